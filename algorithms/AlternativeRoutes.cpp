@@ -1,6 +1,7 @@
 #pragma once
 
 #include "EnvironmentallyFriendly.cpp"
+#include "../utils/ThreadPool.h"
 
 /**
  * @brief Copies path 2, parking node 2, walking time 2, and driving time 2 to path 1, parking node 1,
@@ -28,13 +29,24 @@ void copyIfBetter(std::list<T>& path1, T& parkingNodeId1, int& walkingTime1, int
 
 /**
  * @brief Given a driving-walking path, this function calculates the best alternative path with the same constraints. 
- * The function works by avoiding each of the edges in the path at a time and calculating the best path with the new restriction, using the EnvironmentallyFriendly algorithm which has time complexity of O(log(V)(E+V)).
- * The total complexity is: O(Vlog(V)(E+V)) where V is the number of vertices and E is the number of edges since the maximum number of edges in a path is V-1.
+ * The function works by avoiding each of the edges in the path at a time and finding the best path with the new restriction,
+ * as calculateEnvironmentallyFriendlyPath would. Instead of running both searches again for every edge, one walking search and
+ * one driving search (drivingDijkstraAll) are run with the current constraints and then repaired for each edge: the walking
+ * search is only run again if the edge is on the walking path of a candidate, and the driving tree only has the subtree below
+ * the edge recomputed (see repairDrivingTree). Every candidate parking node is still weighed, so the alternative has the same
+ * times as with full searches. The repaired slots are ranked after all the others rather than in the order drivingDijkstra
+ * would settle them, so among parking nodes of exactly the same total and walking time another one may be picked, and the
+ * driving and walking segments may be other ones of the same times.
+ * The edges are independent: each one gets its own restrictions and search state, so with several threads they are evaluated
+ * concurrently, and their results are then merged in path order with copyIfBetter, which picks the same winner as a serial run.
+ * The total complexity is O(Vlog(V)(E+V)) in the worst case, where V is the number of vertices and E is the number of edges, since
+ * the maximum number of edges in a path is V-1; each edge costs O((S+F)logS), the size of the subtree it cuts.
  * 
  * @tparam T 
  * @param g graph where the path is calculated
- * @param source node where the path starts
- * @param dest node where the path ends
+ * @param ctx search state of the calling thread
+ * @param source slot where the path starts
+ * @param dest slot where the path ends
  * @param maxWalkTime maximum walking time allowed
  * @param avoid_nodes nodes that the path can't go through
  * @param avoid_edges nodes that the path can't go through
@@ -43,36 +55,142 @@ void copyIfBetter(std::list<T>& path1, T& parkingNodeId1, int& walkingTime1, int
  * @param altDrivingTime used to return the driving time of the alternative path
  * @param altWalkingTime used to return the walking time of the alternative path
  * @param altParkingNodeId used to return the parking node id of the alternative path
+ * @param numThreads number of threads evaluating the edges; 0 uses one per hardware thread
  */
 template <class T> 
-void getBestAlternative(const Graph<T>& g, Vertex<T>* source, Vertex<T>* dest, const int maxWalkTime, const std::unordered_set<T>& avoid_nodes, std::unordered_set<std::pair<T, T>, pairHash>& avoid_edges, std::list<T>& previousPath, std::list<T>& altPath, int& altDrivingTime, int& altWalkingTime, T& altParkingNodeId) {
-    std::vector<std::pair<int,int>> newAvoidEdges= {};
+void getBestAlternative(const CsrGraph<T>& g, SearchContext& ctx, int source, int dest, const int maxWalkTime, const std::unordered_set<T>& avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash>& avoid_edges, std::list<T>& previousPath, std::list<T>& altPath, int& altDrivingTime, int& altWalkingTime, T& altParkingNodeId, int numThreads = 1) {
+    std::vector<std::pair<T, T>> newAvoidEdges= {};
     T node = previousPath.front();
     bool found_alternative = false;
     altDrivingTime = std::numeric_limits<int>::max();
     altWalkingTime = std::numeric_limits<int>::max();
     altPath = {};
     for (T nextNode : previousPath) {
-        if (node != nextNode) {
+        if (node != nextNode && avoid_edges.find({node, nextNode}) == avoid_edges.end()) {
             newAvoidEdges.push_back({node, nextNode});
         }
         node = nextNode;
     }
-    for (auto p : newAvoidEdges) {
-        if (avoid_edges.find(p) != avoid_edges.end()) {
-            continue;
-        }
-        std::list<T> tempPath = {};
-        T tempParkingNodeId;
-        int tempWalkingTime = 0;
-        int tempDrivingTime = 0;
-        avoid_edges.insert(p);
-        int err = calculateEnvironmentallyFriendlyPath(g, source, dest, maxWalkTime, avoid_nodes, avoid_edges, tempPath, tempParkingNodeId, tempWalkingTime, tempDrivingTime);
-        if (err == 0) {
+
+    // Searches with the current constraints, shared read-only by every edge
+    std::unordered_map<int, int> reacheableWalkingVertices = {};
+    std::unordered_map<int, int> walkingTree = {};     // walking edge taken from each vertex on a candidate's path, -1 at dest
+    walkingReverseDijsktra(g, ctx, dest, source, maxWalkTime, avoid_nodes, avoid_edges, reacheableWalkingVertices);
+    for (const auto& candidate : reacheableWalkingVertices) {
+        for (int v = candidate.first; walkingTree.find(v) == walkingTree.end();) {
+            int e = ctx.getBackward().getPath(v);
+            walkingTree[v] = e;
+            if (e == -1) {
+                break;
+            }
+            v = g.getEdgeDest(e);
+        }
+    }
+    std::vector<int> settleRank, childBegin, children;
+    drivingDijkstraAll(g, ctx, source, avoid_nodes, avoid_edges, settleRank);
+    getDrivingTreeChildren(g, ctx, childBegin, children);
+    const SearchLabels& driving = ctx.getForward();
+
+    struct Alternative {
+        bool found = false;
+        std::list<T> path = {};
+        T parkingNodeId;
+        int walkingTime = 0, drivingTime = 0;
+    };
+    // Search state of one thread; its context only uses the backward labels, the forward ones of ctx hold the shared tree
+    struct EdgeState {
+        SearchContext walking;
+        SearchLabels repaired;
+        std::vector<int> subtree, subtreeRank;
+    };
+    std::vector<Alternative> alternatives(newAvoidEdges.size());
+    auto evaluate = [&](std::size_t k, EdgeState& state) {
+        std::unordered_set<std::pair<T, T>, pairHash> edges = avoid_edges;
+        edges.insert(newAvoidEdges[k]);
+        int from = g.findSlotById(newAvoidEdges[k].first), to = g.findSlotById(newAvoidEdges[k].second);
+
+        auto walkingEdge = walkingTree.find(from);
+        bool walkingChanged = walkingEdge != walkingTree.end() && walkingEdge->second != -1 && g.getEdgeDest(walkingEdge->second) == to;
+        std::unordered_map<int, int> changedWalkingVertices = {};
+        if (walkingChanged) {
+            walkingReverseDijsktra(g, state.walking, dest, source, maxWalkTime, avoid_nodes, edges, changedWalkingVertices);
+        }
+        const std::unordered_map<int, int>& reacheable = walkingChanged ? changedWalkingVertices : reacheableWalkingVertices;
+        const SearchLabels& walking = state.walking.getBackward();
+
+        bool drivingChanged = driving.getPath(to) != -1 && g.getEdgeOrig(driving.getPath(to)) == from;
+        if (drivingChanged) {
+            SearchRestrictions& restrictions = state.walking.getRestrictions();
+            restrictions.set(g, avoid_nodes, edges);
+            repairDrivingTree(g, ctx, childBegin, children, to, restrictions, state.repaired, state.subtree);
+            // The subtree is settled after every other slot, in the order of the repair
+            state.subtreeRank.resize(g.getNumVertex());
+            for (std::size_t i = 0; i < state.subtree.size(); i++) {
+                state.subtreeRank[state.subtree[i]] = g.getNumVertex() + i;
+            }
+        }
+        auto inSubtree = [&](int v) { return drivingChanged && state.repaired.isVisited(v); };
+        auto drivingDist = [&](int v) { return inSubtree(v) ? state.repaired.getDist(v) : driving.getDist(v); };
+        auto drivingEdge = [&](int v) { return inSubtree(v) ? state.repaired.getPath(v) : driving.getPath(v); };
+
+        // Candidates in the order drivingDijkstra would settle them, as in selectParkingNode
+        std::vector<std::pair<int, int>> reached;
+        for (const auto& candidate : reacheable) {
+            if (candidate.first != source && drivingDist(candidate.first) != std::numeric_limits<int>::max()) {
+                reached.push_back({inSubtree(candidate.first) ? state.subtreeRank[candidate.first] : settleRank[candidate.first], candidate.first});
+            }
+        }
+        std::sort(reached.begin(), reached.end());
+        int parkingNode = -1;
+        long long parkingNodeCost = std::numeric_limits<int>::max();
+        Alternative& alternative = alternatives[k];
+        for (const auto& candidate : reached) {
+            int walk = reacheable.at(candidate.second);
+            long long cost = (long long) walk + drivingDist(candidate.second);
+            if (cost < parkingNodeCost || (cost == parkingNodeCost && walk > alternative.walkingTime)) {
+                parkingNode = candidate.second;
+                parkingNodeCost = cost;
+                alternative.walkingTime = walk;
+                alternative.drivingTime = drivingDist(candidate.second);
+            }
+        }
+        if (parkingNode == -1) {
+            return;
+        }
+        alternative.found = true;
+        alternative.parkingNodeId = g.getId(parkingNode);
+        int e = walkingChanged ? walking.getPath(parkingNode) : walkingTree.at(parkingNode);
+        while (e != -1) {
+            alternative.path.push_back(g.getId(g.getEdgeDest(e)));
+            e = walkingChanged ? walking.getPath(g.getEdgeDest(e)) : walkingTree.at(g.getEdgeDest(e));
+        }
+        alternative.path.push_front(g.getId(parkingNode));
+        for (e = drivingEdge(parkingNode); e != -1; e = drivingEdge(g.getEdgeOrig(e))) {
+            alternative.path.push_front(g.getId(g.getEdgeOrig(e)));
+        }
+    };
+
+    if (numThreads == 0) {
+        numThreads = ThreadPool::hardwareThreads();
+    }
+    numThreads = std::max(1, std::min<int>(numThreads, newAvoidEdges.size()));
+    std::vector<EdgeState> states(numThreads);
+    if (numThreads == 1) {
+        for (std::size_t k = 0; k < newAvoidEdges.size(); k++) {
+            evaluate(k, states[0]);
+        }
+    } else {
+        ThreadPool pool(numThreads);
+        for (std::size_t k = 0; k < newAvoidEdges.size(); k++) {
+            pool.submit([&evaluate, &states, k](int worker) { evaluate(k, states[worker]); });
+        }
+        pool.wait();
+    }
+    for (Alternative& alternative : alternatives) {
+        if (alternative.found) {
             found_alternative = true;
-            copyIfBetter(altPath, altParkingNodeId, altWalkingTime, altDrivingTime, tempPath, tempParkingNodeId, tempWalkingTime, tempDrivingTime);
+            copyIfBetter(altPath, altParkingNodeId, altWalkingTime, altDrivingTime, alternative.path, alternative.parkingNodeId, alternative.walkingTime, alternative.drivingTime);
         }
-        avoid_edges.erase(p);
     }
     if (!found_alternative) {
         altPath = {};
@@ -81,6 +199,61 @@ void getBestAlternative(const Graph<T>& g, Vertex<T>* source, Vertex<T>* dest, c
     }
 }
 
+/**
+ * @brief Extends a complete search to the nodes and edges that before avoids and after no longer does, so the labels become
+ * those of a search under after. Dropping restrictions only shortens paths: the newly allowed edges out of reached slots are
+ * relaxed, and only the slots whose time drops are settled again, by a Dijkstra seeded with them.
+ * Total time complexity is O(V + E + (S+F)logS), where S is the number of slots whose time drops and F the edges out of them.
+ *
+ * @tparam T
+ * @param g graph where the search was performed
+ * @param labels labels of a complete search under before, without a time limit; updated in place
+ * @param walking whether the search is the reverse walking search, over the incoming edges and walking times, rather than
+ * the driving search
+ * @param before restrictions of the search that left labels
+ * @param after restrictions to extend it to, avoiding a subset of what before avoids
+ */
+template <class T>
+void extendSearchTree(const CsrGraph<T>& g, SearchLabels& labels, bool walking, const SearchRestrictions& before, const SearchRestrictions& after) {
+    const int inf = std::numeric_limits<int>::max();
+    SlotPriorityQueue pq(labels.getDistArray(), labels.getQueueIndexArray());
+    // Relaxes the edge e, of the given time, from the reached slot v into u; newlyAllowed only takes edges before avoided
+    auto relaxEdges = [&](int v, bool newlyAllowed) {
+        int begin = walking ? g.inBegin(v) : g.outBegin(v);
+        int end = walking ? g.inEnd(v) : g.outEnd(v);
+        for (int i = begin; i < end; i++) {
+            int u = walking ? g.getInOrig(i) : g.getEdgeDest(i);
+            int e = walking ? g.getInEdge(i) : i;
+            int time = walking ? g.getInWalkingTime(i) : g.getDrivingTime(i);
+            if (newlyAllowed && !before.isNodeAvoided(u) && !before.isEdgeAvoided(e)) {
+                continue;
+            }
+            if (time == inf || after.isNodeAvoided(u) || after.isEdgeAvoided(e) || (long long) labels.getDist(v) + time >= labels.getDist(u)) {
+                continue;
+            }
+            labels.setDist(u, labels.getDist(v) + time);
+            labels.setPath(u, e);
+            if (labels.isProcessing(u)) {
+                pq.decreaseKey(u);
+            } else {
+                labels.setVisited(u, true);
+                labels.setProcessing(u, true);
+                pq.insert(u);
+            }
+        }
+    };
+    for (int v = 0; v < g.getNumVertex(); v++) {
+        if (labels.getDist(v) != inf) {
+            relaxEdges(v, true);
+        }
+    }
+    while (!pq.empty()) {
+        int v = pq.extractMin();
+        labels.setProcessing(v, false);
+        relaxEdges(v, false);
+    }
+}
+
 /**
  * @brief Given that no path was found with the constraints, this function tries to remove each constraint one by one and find one path and an alternative to it with the same constraints.
  * The order by which constraints are removed is the following:
@@ -91,11 +264,20 @@ void getBestAlternative(const Graph<T>& g, Vertex<T>* source, Vertex<T>* dest, c
  * - Maximum walking time and node avoidance constraints
  * - Node and edge avoidance constraints
  * - No constraints, except that the path must include driving and walking segments (must include a parking node which isn't the source or destination)
+ * The relaxations share their search trees instead of each running calculateEnvironmentallyFriendlyPath. One walking search
+ * from dest, without a time limit, and one driving search from source, over the whole graph, are run with both avoid lists;
+ * the trees of the relaxations that drop an avoid list are extended from those (see extendSearchTree), once each, and a
+ * relaxation with the walking limit only leaves out the candidates beyond it. Each relaxation then weighs every parking
+ * node, with the same rules as calculateEnvironmentallyFriendlyPath, in O(V): the times are the same, though among parking
+ * nodes of exactly the same times another one may be picked, and the segments may be other ones of the same times.
+ * Total time complexity is O((V+E)logV) for the first two searches plus the part of the graph each extension reaches again,
+ * and getBestAlternative for the route found.
  * 
  * @tparam T 
  * @param g graph where the path is calculated
- * @param source vertex that the path starts in
- * @param dest vertex where the path ends
+ * @param ctx search state of the calling thread
+ * @param source slot that the path starts in
+ * @param dest slot where the path ends
  * @param maxWalkTime maximum allowed walking time
  * @param avoid_nodes nodes that the path can't go through
  * @param avoid_edges edges that the path can't go through
@@ -107,79 +289,117 @@ void getBestAlternative(const Graph<T>& g, Vertex<T>* source, Vertex<T>* dest, c
  * @param parkingNodeId2 used to return the parking node id of the second alternative path
  * @param walkingTime2 used to return the walking time of the second alternative path
  * @param drivingTime2 used to return the driving time of the second alternative path
+ * @param numThreads number of threads searching for the alternative; 0 uses one per hardware thread
  * @return std::string returns a message indicating the constraints that were removed to find the alternative paths
  */
 template <class T>
-std::string AlternativeRoutes(const Graph<T>& g, Vertex<T>* source, Vertex<T>* dest, const int maxWalkTime, const std::unordered_set<T>& avoid_nodes, std::unordered_set<std::pair<T, T>, pairHash>& avoid_edges, std::list<T>& path1, T& parkingNodeId1, int& walkingTime1, int& drivingTime1,  std::list<T>& path2, T& parkingNodeId2, int& walkingTime2, int& drivingTime2) {
-    std::list<T> tempPath = {};
-    T tempParkingNodeId;
-    int tempWalkingTime = std::numeric_limits<int>::max();
-    int tempDrivingTime = std::numeric_limits<int>::max();
-    std::unordered_set<std::pair<T, T>, pairHash> emptyAvoidEdges = {};
-    std::unordered_set<T> emptyAvoidNodes = {};
-    walkingTime1 = drivingTime1 = walkingTime2 = drivingTime2 = std::numeric_limits<int>::max();
-    // Try removing maximum walking time constraint
-    {
-        int err = calculateEnvironmentallyFriendlyPath(g, source, dest, std::numeric_limits<int>::max(), avoid_nodes, avoid_edges, tempPath, tempParkingNodeId, tempWalkingTime, tempDrivingTime);
-        if (err == 0) {
-            copyIfBetter(path1, parkingNodeId1, walkingTime1, drivingTime1, tempPath, tempParkingNodeId, tempWalkingTime, tempDrivingTime);
-            getBestAlternative(g, source, dest, std::numeric_limits<int>::max(), avoid_nodes, avoid_edges, path1, path2, drivingTime2, walkingTime2, parkingNodeId2);
-            return "No possible route with max. walking time of " + std::to_string(maxWalkTime) + " minutes.";
+std::string AlternativeRoutes(const CsrGraph<T>& g, SearchContext& ctx, int source, int dest, const int maxWalkTime, const std::unordered_set<T>& avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash>& avoid_edges, std::list<T>& path1, T& parkingNodeId1, int& walkingTime1, int& drivingTime1,  std::list<T>& path2, T& parkingNodeId2, int& walkingTime2, int& drivingTime2, int numThreads = 1) {
+    const int noLimit = std::numeric_limits<int>::max();
+    const std::unordered_set<std::pair<T, T>, pairHash> emptyAvoidEdges = {};
+    const std::unordered_set<T> emptyAvoidNodes = {};
+    // trees selects the search trees of the relaxation: 1 if it keeps avoid_nodes, plus 2 if it keeps avoid_edges
+    struct Relaxation {
+        int maxWalkTime;
+        int trees;
+        const std::unordered_set<T>& avoidNodes;
+        const std::unordered_set<std::pair<T, T>, pairHash>& avoidEdges;
+        std::string message;
+    };
+    const std::vector<Relaxation> relaxations = {
+        // Try removing maximum walking time constraint
+        {noLimit, 3, avoid_nodes, avoid_edges, "No possible route with max. walking time of " + std::to_string(maxWalkTime) + " minutes."},
+        // Try removing edge avoidance constraint
+        {maxWalkTime, 1, avoid_nodes, emptyAvoidEdges, "Could not find a path with edge avoidance constraint."},
+        // Try removing node avoidance constraint
+        {maxWalkTime, 2, emptyAvoidNodes, avoid_edges, "Could not find a path with node avoidance constraint."},
+        // Try removing maximum walking time and edge avoidance constraints
+        {noLimit, 1, avoid_nodes, emptyAvoidEdges, "Could not find a path with maximum walking time or edge avoidance constraint."},
+        // Try removing maximum walking time and node avoidance constraints
+        {noLimit, 2, emptyAvoidNodes, avoid_edges, "Could not find a path with maximum walking time or node avoidance constraint."},
+        // Try removing node and edge avoidance constraints
+        {maxWalkTime, 0, emptyAvoidNodes, emptyAvoidEdges, "Could not find a path with node or edge avoidance constraint."},
+        // Try removing all constraints
+        {noLimit, 0, emptyAvoidNodes, emptyAvoidEdges, "Could not find a path with maximum walking time, or node, or edge avoidance constraint."},
+    };
+    struct SearchTrees {
+        bool built = false;
+        SearchRestrictions restrictions;
+        SearchLabels walking;   // reverse walking search from dest, without a time limit
+        SearchLabels driving;   // driving search from source over the whole graph
+    };
+    SearchTrees trees[4];
+    std::vector<int> settleRank;
+    // Builds the trees of a relaxation, and the stricter ones it is extended from, the first time they are needed
+    auto getTrees = [&](int index) -> const SearchTrees& {
+        int previous = -1;
+        for (int i : {3, index | 1, index}) {
+            SearchTrees& current = trees[i];
+            if (!current.built) {
+                current.restrictions.set(g, i & 1 ? avoid_nodes : emptyAvoidNodes, i & 2 ? avoid_edges : emptyAvoidEdges);
+                if (previous == -1) {
+                    std::unordered_map<int, int> reacheable = {};
+                    walkingReverseDijsktra(g, ctx, dest, source, noLimit, avoid_nodes, avoid_edges, reacheable);
+                    drivingDijkstraAll(g, ctx, source, avoid_nodes, avoid_edges, settleRank);
+                    current.walking = ctx.getBackward();
+                    current.driving = ctx.getForward();
+                } else {
+                    current.walking = trees[previous].walking;
+                    current.driving = trees[previous].driving;
+                    extendSearchTree(g, current.walking, true, trees[previous].restrictions, current.restrictions);
+                    extendSearchTree(g, current.driving, false, trees[previous].restrictions, current.restrictions);
+                }
+                current.built = true;
+            }
+            previous = i;
         }
-    }
-    // Try removing edge avoidance constraint
-    {
-        int err = calculateEnvironmentallyFriendlyPath(g, source, dest, maxWalkTime, avoid_nodes, emptyAvoidEdges, tempPath, tempParkingNodeId, tempWalkingTime, tempDrivingTime);
-        if (err == 0) {
-            copyIfBetter(path1, parkingNodeId1, walkingTime1, drivingTime1, tempPath, tempParkingNodeId, tempWalkingTime, tempDrivingTime);
-            getBestAlternative(g, source, dest, maxWalkTime, avoid_nodes, emptyAvoidEdges, path1, path2, drivingTime2, walkingTime2, parkingNodeId2);
-            return "Could not find a path with edge avoidance constraint.";
+        return trees[index];
+    };
+    struct Route {
+        std::list<T> path = {};
+        T parkingNodeId;
+        int walkingTime = std::numeric_limits<int>::max(), drivingTime = std::numeric_limits<int>::max();
+    };
+    // Picks the parking node of a relaxation as drivingDijkstra would, preferring the longer walk among equal totals
+    auto search = [&](const Relaxation& relaxation, Route& route) {
+        const SearchTrees& searchTrees = getTrees(relaxation.trees);
+        int parkingNode = -1;
+        long long parkingNodeCost = noLimit;
+        for (int v = 0; v < g.getNumVertex(); v++) {
+            int walk = searchTrees.walking.getDist(v), drive = searchTrees.driving.getDist(v);
+            if (!g.getParking(v) || v == source || v == dest || walk == noLimit || walk > relaxation.maxWalkTime || drive == noLimit) {
+                continue;
+            }
+            long long cost = (long long) walk + drive;
+            if (cost < parkingNodeCost || (cost == parkingNodeCost && walk > route.walkingTime)) {
+                parkingNode = v;
+                parkingNodeCost = cost;
+                route.walkingTime = walk;
+                route.drivingTime = drive;
+            }
         }
-    }
-    // Try removing node avoidance constraint
-    {
-        int err = calculateEnvironmentallyFriendlyPath(g, source, dest, maxWalkTime, emptyAvoidNodes, avoid_edges, tempPath, tempParkingNodeId, tempWalkingTime, tempDrivingTime);
-        if (err == 0) {
-            copyIfBetter(path1, parkingNodeId1, walkingTime1, drivingTime1, tempPath, tempParkingNodeId, tempWalkingTime, tempDrivingTime);
-            getBestAlternative(g, source, dest, maxWalkTime,emptyAvoidNodes, avoid_edges, path1, path2, drivingTime2, walkingTime2, parkingNodeId2);
-            return "Could not find a path with node avoidance constraint.";
+        if (parkingNode == -1) {
+            return false;
         }
-    }
-    // Try removing maximum walking time and edge avoidance constraints
-    {
-        int err = calculateEnvironmentallyFriendlyPath(g, source, dest, std::numeric_limits<int>::max(), avoid_nodes, emptyAvoidEdges, tempPath, tempParkingNodeId, tempWalkingTime, tempDrivingTime);
-        if (err == 0) {
-            copyIfBetter(path1, parkingNodeId1, walkingTime1, drivingTime1, tempPath, tempParkingNodeId, tempWalkingTime, tempDrivingTime);
-            getBestAlternative(g, source, dest, std::numeric_limits<int>::max(), avoid_nodes, emptyAvoidEdges, path1, path2, drivingTime2, walkingTime2, parkingNodeId2);
-            return "Could not find a path with maximum walking time or edge avoidance constraint.";
-        }
-    }
-    // Try removing maximum walking time and node avoidance constraints
-    {
-        int err = calculateEnvironmentallyFriendlyPath(g, source, dest, std::numeric_limits<int>::max(), emptyAvoidNodes, avoid_edges, tempPath, tempParkingNodeId, tempWalkingTime, tempDrivingTime);
-        if (err == 0) {
-            copyIfBetter(path1, parkingNodeId1, walkingTime1, drivingTime1, tempPath, tempParkingNodeId, tempWalkingTime, tempDrivingTime);
-            getBestAlternative(g, source, dest, std::numeric_limits<int>::max(), emptyAvoidNodes, avoid_edges, path1, path2, drivingTime2, walkingTime2, parkingNodeId2);
-            return "Could not find a path with maximum walking time or node avoidance constraint.";
-        }
-    }
-    // Try removing node and edge avoidance constraints
-    {
-        int err = calculateEnvironmentallyFriendlyPath(g, source, dest, maxWalkTime, emptyAvoidNodes, emptyAvoidEdges, tempPath, tempParkingNodeId, tempWalkingTime, tempDrivingTime);
-        if (err == 0) {
-            copyIfBetter(path1, parkingNodeId1, walkingTime1, drivingTime1, tempPath, tempParkingNodeId, tempWalkingTime, tempDrivingTime);
-            getBestAlternative(g, source, dest, maxWalkTime,emptyAvoidNodes, emptyAvoidEdges, path1, path2, drivingTime2, walkingTime2, parkingNodeId2);
-            return "Could not find a path with node or edge avoidance constraint.";
+        route.parkingNodeId = g.getId(parkingNode);
+        for (int e = searchTrees.walking.getPath(parkingNode); e != -1; e = searchTrees.walking.getPath(g.getEdgeDest(e))) {
+            route.path.push_back(g.getId(g.getEdgeDest(e)));
         }
+        getDrivingPath(g, searchTrees.driving, parkingNode, route.path);
+        return true;
+    };
+
+    std::size_t first = source == -1 || dest == -1 ? relaxations.size() : 0;
+    Route route;
+    while (first < relaxations.size() && !search(relaxations[first], route)) {
+        route = Route();
+        first++;
     }
-    // Try removing all constraints
-    {
-        int err = calculateEnvironmentallyFriendlyPath(g, source, dest, std::numeric_limits<int>::max(), emptyAvoidNodes, emptyAvoidEdges, tempPath, tempParkingNodeId, tempWalkingTime, tempDrivingTime);
-        if (err == 0) {
-            copyIfBetter(path1, parkingNodeId1, walkingTime1, drivingTime1, tempPath, tempParkingNodeId, tempWalkingTime, tempDrivingTime);
-            getBestAlternative(g, source, dest, std::numeric_limits<int>::max(), emptyAvoidNodes, emptyAvoidEdges, path1, path2, drivingTime2, walkingTime2, parkingNodeId2);
-            return "Could not find a path with maximum walking time, or node, or edge avoidance constraint.";
-        }
+
+    walkingTime1 = drivingTime1 = walkingTime2 = drivingTime2 = noLimit;
+    if (first == relaxations.size()) {
+        return "Could not find any path walking and driving from source to destination.";
     }
-    return "Could not find any path walking and driving from source to destination.";
-}
\ No newline at end of file
+    copyIfBetter(path1, parkingNodeId1, walkingTime1, drivingTime1, route.path, route.parkingNodeId, route.walkingTime, route.drivingTime);
+    getBestAlternative(g, ctx, source, dest, relaxations[first].maxWalkTime, relaxations[first].avoidNodes, relaxations[first].avoidEdges, path1, path2, drivingTime2, walkingTime2, parkingNodeId2, numThreads);
+    return relaxations[first].message;
+}
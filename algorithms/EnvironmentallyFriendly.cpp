@@ -1,69 +1,76 @@
 #pragma once
 
-#include "../utils/Graph.h"
+#include "../utils/CsrGraph.hpp"
+#include "../utils/SlotPriorityQueue.h"
+#include "../utils/BucketQueue.h"
+#include "../utils/SearchContext.hpp"
+#include "../utils/Landmarks.hpp"
+#include "../utils/WalkingIndex.hpp"
+#include "../utils/AllPairs.hpp"
 #include "../utils/GraphInitialization.cpp"
 #include "../utils/PairHash.hpp"
 #include "../utils/GetDrivingPath.hpp"
+#include <unordered_map>
 #include <unordered_set>
 #include <list>
+#include <algorithm>
+#include <queue>
+#include <vector>
 
 /**
  * @brief Performs a Dijkstra's algorithm from source backwards (in the incoming edges of each node) using as distance the walking distance.
  * Total complexity is O((V+E)logV) where V is the number of vertices and E is the number of edges in the graph.
  * 
  * @tparam T 
+ * @tparam PQ queue of the search: SlotPriorityQueue, or DialQueue or RadixHeap from BucketQueue.h.
  * @param g graph where the Dijkstra will be performed.
- * @param source node from which the Dijkstra will be calculated. Should be the destination of the path.
+ * @param ctx search state of the calling thread; the walking edges are left in its backward labels.
+ * @param source slot from which the Dijkstra will be calculated. Should be the destination of the path.
  * @param maxWalkTime maximum walking time allowed.
  * @param avoid_nodes nodes that the path can't go through.
  * @param avoid_edges edges that the path can't go through.
- * @param reacheableVertices map that relates ids of vertices and the time needed to reach source from them walking. Only nodes which have parking spots and that are at a walking distance smaller than maxWalkTime are included.
- * @param visitedVertices should be initialized as an empty vector. It will contain all the vertices visited during the algorithm.
+ * @param reacheableVertices map that relates slots of vertices and the time needed to reach source from them walking. Only nodes which have parking spots and that are at a walking distance smaller than maxWalkTime are included.
  * @return int returns 0 as success, -1 if no reacheable vertices were found.
  */
-template <class T>
-int walkingReverseDijsktra(const Graph<T>& g, Vertex<T>* source, Vertex<T>* dest, const int maxWalkTime, const std::unordered_set<T>& avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash>& avoid_edges, std::unordered_map<Vertex<T>*, double>& reacheableVertices, std::vector<Vertex<T>*>& visitedVertices) {
-    if (source == nullptr) {
+template <class T, class PQ = SlotPriorityQueue>
+int walkingReverseDijsktra(const CsrGraph<T>& g, SearchContext& ctx, int source, int dest, const int maxWalkTime, const std::unordered_set<T>& avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash>& avoid_edges, std::unordered_map<int, int>& reacheableVertices) {
+    if (source == -1) {
         return -1;
     }
-    source->setDist(0);
-    MutablePriorityQueue<Vertex<T>> pq;
-    visitedVertices.push_back(source);
+    SearchLabels& labels = ctx.getBackward();
+    labels.reset(g.getNumVertex());
+    SearchRestrictions& restrictions = ctx.getRestrictions();
+    restrictions.set(g, avoid_nodes, avoid_edges);
+    labels.setDist(source, 0);
+    PQ pq(labels.getDistArray(), labels.getQueueIndexArray());
     pq.insert(source);
     while (!pq.empty()) {
-        Vertex<T>* v = pq.extractMin();
-        v->setProcessing(false);
-        if (v->getDist() > maxWalkTime) {
-            cleanUpVisitedAndDist(visitedVertices);
-            if (reacheableVertices.size() == 0) {
-                return -1;
-            } else {
-                return 0;
-            }
+        int v = pq.extractMin();
+        labels.setProcessing(v, false);
+        if (labels.getDist(v) > maxWalkTime) {
+            break;
         }
-        if (v->getParking() && v != source && v!=dest) {
-            reacheableVertices.insert({v, v->getDist()});
+        if (g.getParking(v) && v != source && v != dest) {
+            reacheableVertices.insert({v, labels.getDist(v)});
         }
-        for (Edge<T>* e : v->getIncoming()) {
-            Vertex<T>* u = e->getOrig();
-            if (v->getDist() == std::numeric_limits<int>::max() || e->getWalkingTime() == std::numeric_limits<int>::max() || (u->isVisited()&&!u->isProcessing()) || avoid_nodes.find(u->getId()) != avoid_nodes.end() || avoid_edges.find({u->getId(), v->getId()}) != avoid_edges.end()) {
+        for (int i = g.inBegin(v); i < g.inEnd(v); i++) {
+            int u = g.getInOrig(i);
+            if (labels.getDist(v) == std::numeric_limits<int>::max() || g.getInWalkingTime(i) == std::numeric_limits<int>::max() || (labels.isVisited(u)&&!labels.isProcessing(u)) || restrictions.isNodeAvoided(u) || restrictions.isEdgeAvoided(g.getInEdge(i))) {
                 continue;
             }
-            if (u->getDist() > v->getDist() + e->getWalkingTime()) {
-                u->setDist(v->getDist() + e->getWalkingTime());
-                u->setWalkingPath(e);
-                if (!u->isVisited()) {
+            if (labels.getDist(u) > labels.getDist(v) + g.getInWalkingTime(i)) {
+                labels.setDist(u, labels.getDist(v) + g.getInWalkingTime(i));
+                labels.setPath(u, g.getInEdge(i));
+                if (!labels.isVisited(u)) {
                     pq.insert(u);
-                    visitedVertices.push_back(u);
-                    u->setVisited(true);
-                    u->setProcessing(true);
-                } else if (u->isProcessing()) {
+                    labels.setVisited(u, true);
+                    labels.setProcessing(u, true);
+                } else if (labels.isProcessing(u)) {
                     pq.decreaseKey(u);
                 }
             }
         }
     }
-    cleanUpVisitedAndDist(visitedVertices);
     if (reacheableVertices.size() == 0) {
         return -1;
     } else {
@@ -76,65 +83,356 @@ int walkingReverseDijsktra(const Graph<T>& g, Vertex<T>* source, Vertex<T>* dest
  * complexity is O((V+E)logV) where V is the number of vertices and E is the number of edges in the graph.
  * 
  * @tparam T 
+ * @tparam PQ queue of the search; among parking nodes of equal total and walking time, the one it settles first is picked
  * @param g graph
- * @param source the node from which the Dijkstra will be performed
+ * @param ctx search state of the calling thread; the driving edges are left in its forward labels
+ * @param source the slot from which the Dijkstra will be performed
  * @param avoidNodes nodes that the path can't go through
  * @param avoidEdges edges that the path can't go through
- * @param reacheableWalkingVertices map between the ids of nodes that are candidates to be parking nodes and the time needed to walk to them from source
+ * @param reacheableWalkingVertices map between the slots of nodes that are candidates to be parking nodes and the time needed to walk to them from source
  * @param walkingTime used to return the walking time of the best path
  * @param drivingTime used to return the driving time of the best path
- * @param visitedVertices vertices that the Dijsktra visited
- * @return Vertex<T>* 
+ * @return int slot of the parking node, or -1 if none was reached
  */
-template <class T>
-Vertex<T>* drivingDijkstra(const Graph<T>& g, Vertex<T>* source, const std::unordered_set<T>& avoidNodes, const std::unordered_set<std::pair<T, T>, pairHash>& avoidEdges, std::unordered_map<Vertex<T>*, double>& reacheableWalkingVertices, int& walkingTime, int& drivingTime, std::vector<Vertex<T>*>& visitedVertices) {
-   if (source == nullptr) {
-       return nullptr;
+template <class T, class PQ = SlotPriorityQueue>
+int drivingDijkstra(const CsrGraph<T>& g, SearchContext& ctx, int source, const std::unordered_set<T>& avoidNodes, const std::unordered_set<std::pair<T, T>, pairHash>& avoidEdges, std::unordered_map<int, int>& reacheableWalkingVertices, int& walkingTime, int& drivingTime) {
+   if (source == -1) {
+       return -1;
    }
-   Vertex<T>* parkingNode = nullptr;
-   int parkingNodeCost = std::numeric_limits<int>::max();
+   int parkingNode = -1;
+   long long parkingNodeCost = std::numeric_limits<int>::max();
    int numReacheableWalkingVertices = reacheableWalkingVertices.size();
-   source->setDist(0);
-   MutablePriorityQueue<Vertex<T>> pq;
-   visitedVertices.push_back(source);
+   SearchLabels& labels = ctx.getForward();
+   labels.reset(g.getNumVertex());
+   SearchRestrictions& restrictions = ctx.getRestrictions();
+   restrictions.set(g, avoidNodes, avoidEdges);
+   labels.setDist(source, 0);
+   PQ pq(labels.getDistArray(), labels.getQueueIndexArray());
    pq.insert(source);
    while (!pq.empty()) {
-      Vertex<T>* v = pq.extractMin();
-      v->setProcessing(false);
-      if (reacheableWalkingVertices.find(v) != reacheableWalkingVertices.end()) {
+      int v = pq.extractMin();
+      labels.setProcessing(v, false);
+      auto it = reacheableWalkingVertices.find(v);
+      if (it != reacheableWalkingVertices.end()) {
          numReacheableWalkingVertices--;
-         auto it = reacheableWalkingVertices.find(v);
-         if (v != source && ((it->second + v->getDist() < parkingNodeCost) || (it->second + v->getDist() == parkingNodeCost && it->second > walkingTime))) {
+         long long cost = (long long) it->second + labels.getDist(v);
+         if (v != source && (cost < parkingNodeCost || (cost == parkingNodeCost && it->second > walkingTime))) {
             parkingNode = v;
-            parkingNodeCost = it->second + v->getDist();
+            parkingNodeCost = cost;
             walkingTime = it->second;
-            drivingTime = v->getDist();
+            drivingTime = labels.getDist(v);
          }
          if (numReacheableWalkingVertices == 0) {
-            cleanUpVisitedAndDist(visitedVertices);
             return parkingNode;
          }
       }
-      for (Edge<T>* e : v->getAdj()) {
-         Vertex<T>* u = e->getDest();
-         if (v->getDist() == std::numeric_limits<int>::max() || e->getDrivingTime() == std::numeric_limits<int>::max() || (u->isVisited()&&!u->isProcessing()) || avoidNodes.find(u->getId()) != avoidNodes.end() || avoidEdges.find({v->getId(), u->getId()}) != avoidEdges.end()) {
+      for (int e = g.outBegin(v); e < g.outEnd(v); e++) {
+         int u = g.getEdgeDest(e);
+         if (labels.getDist(v) == std::numeric_limits<int>::max() || g.getDrivingTime(e) == std::numeric_limits<int>::max() || (labels.isVisited(u)&&!labels.isProcessing(u)) || restrictions.isNodeAvoided(u) || restrictions.isEdgeAvoided(e)) {
+           continue;
+         }
+         if (labels.getDist(u) > labels.getDist(v) + g.getDrivingTime(e)) {
+           labels.setDist(u, labels.getDist(v) + g.getDrivingTime(e));
+           labels.setPath(u, e);
+           if (!labels.isVisited(u)) {
+               pq.insert(u);
+               labels.setVisited(u, true);
+               labels.setProcessing(u, true);
+           } else if (labels.isProcessing(u)) {
+               pq.decreaseKey(u);
+           }
+         }
+      }
+   }
+   return parkingNode;
+}
+
+/**
+ * @brief Variant of drivingDijkstra that settles every vertex reachable from source instead of stopping at the parking candidates,
+ * so that one search serves every query with the same source and restrictions, whatever its destination. The labels are the ones
+ * drivingDijkstra would leave for the vertices it settles, and settleRank records the order in which each vertex was settled.
+ * Total complexity is O((V+E)logV) where V is the number of vertices and E is the number of edges in the graph.
+ *
+ * @tparam T
+ * @tparam PQ queue of the search, the same as drivingDijkstra's for the settling order to match
+ * @param g graph
+ * @param ctx search state of the calling thread; the driving edges are left in its forward labels
+ * @param source the slot from which the Dijkstra will be performed
+ * @param avoidNodes nodes that the path can't go through
+ * @param avoidEdges edges that the path can't go through
+ * @param settleRank resized to V; the entry of each reached slot is its position in the settling order, the others are stale
+ */
+template <class T, class PQ = SlotPriorityQueue>
+void drivingDijkstraAll(const CsrGraph<T>& g, SearchContext& ctx, int source, const std::unordered_set<T>& avoidNodes, const std::unordered_set<std::pair<T, T>, pairHash>& avoidEdges, std::vector<int>& settleRank) {
+   SearchLabels& labels = ctx.getForward();
+   labels.reset(g.getNumVertex());
+   settleRank.resize(g.getNumVertex());
+   if (source == -1) {
+       return;
+   }
+   SearchRestrictions& restrictions = ctx.getRestrictions();
+   restrictions.set(g, avoidNodes, avoidEdges);
+   int rank = 0;
+   labels.setDist(source, 0);
+   PQ pq(labels.getDistArray(), labels.getQueueIndexArray());
+   pq.insert(source);
+   while (!pq.empty()) {
+      int v = pq.extractMin();
+      labels.setProcessing(v, false);
+      settleRank[v] = rank++;
+      for (int e = g.outBegin(v); e < g.outEnd(v); e++) {
+         int u = g.getEdgeDest(e);
+         if (labels.getDist(v) == std::numeric_limits<int>::max() || g.getDrivingTime(e) == std::numeric_limits<int>::max() || (labels.isVisited(u)&&!labels.isProcessing(u)) || restrictions.isNodeAvoided(u) || restrictions.isEdgeAvoided(e)) {
+           continue;
+         }
+         if (labels.getDist(u) > labels.getDist(v) + g.getDrivingTime(e)) {
+           labels.setDist(u, labels.getDist(v) + g.getDrivingTime(e));
+           labels.setPath(u, e);
+           if (!labels.isVisited(u)) {
+               pq.insert(u);
+               labels.setVisited(u, true);
+               labels.setProcessing(u, true);
+           } else if (labels.isProcessing(u)) {
+               pq.decreaseKey(u);
+           }
+         }
+      }
+   }
+}
+
+/**
+ * @brief After a drivingDijkstraAll from source, picks the parking node among reacheableWalkingVertices exactly as drivingDijkstra
+ * would: the candidates are considered in settling order and ties keep preferring the longer walk.
+ * Total complexity is O(K log K) where K is the number of candidates.
+ *
+ * @param ctx search state holding the labels of drivingDijkstraAll
+ * @param source the slot from which drivingDijkstraAll was performed
+ * @param settleRank settling order filled by drivingDijkstraAll
+ * @param reacheableWalkingVertices map between the slots of nodes that are candidates to be parking nodes and the time needed to walk to them from source
+ * @param walkingTime used to return the walking time of the best path
+ * @param drivingTime used to return the driving time of the best path
+ * @return int slot of the parking node, or -1 if none was reached
+ */
+int selectParkingNode(const SearchContext& ctx, int source, const std::vector<int>& settleRank, const std::unordered_map<int, int>& reacheableWalkingVertices, int& walkingTime, int& drivingTime) {
+   const SearchLabels& labels = ctx.getForward();
+   std::vector<std::pair<int, int>> reached;
+   for (const auto& candidate : reacheableWalkingVertices) {
+      if (candidate.first != source && labels.getDist(candidate.first) != std::numeric_limits<int>::max()) {
+         reached.push_back({settleRank[candidate.first], candidate.first});
+      }
+   }
+   std::sort(reached.begin(), reached.end());
+   int parkingNode = -1;
+   long long parkingNodeCost = std::numeric_limits<int>::max();
+   for (const auto& candidate : reached) {
+      int v = candidate.second;
+      int walk = reacheableWalkingVertices.at(v);
+      long long cost = (long long) walk + labels.getDist(v);
+      if (cost < parkingNodeCost || (cost == parkingNodeCost && walk > walkingTime)) {
+         parkingNode = v;
+         parkingNodeCost = cost;
+         walkingTime = walk;
+         drivingTime = labels.getDist(v);
+      }
+   }
+   return parkingNode;
+}
+
+/**
+ * @brief Lists the children of every slot in the driving tree left by drivingDijkstraAll, the slots reached through it.
+ * Runs in O(V) time.
+ *
+ * @param ctx search state holding the labels of drivingDijkstraAll
+ * @param childBegin resized to V+1; the children of v are children[childBegin[v]] to children[childBegin[v + 1] - 1]
+ * @param children used to return the children of every slot
+ */
+template <class T>
+void getDrivingTreeChildren(const CsrGraph<T>& g, const SearchContext& ctx, std::vector<int>& childBegin, std::vector<int>& children) {
+   const SearchLabels& labels = ctx.getForward();
+   int n = g.getNumVertex();
+   childBegin.assign(n + 1, 0);
+   for (int v = 0; v < n; v++) {
+      if (labels.getPath(v) != -1) {
+         childBegin[g.getEdgeOrig(labels.getPath(v)) + 1]++;
+      }
+   }
+   for (int v = 0; v < n; v++) {
+      childBegin[v + 1] += childBegin[v];
+   }
+   children.resize(childBegin[n]);
+   std::vector<int> next(childBegin.begin(), childBegin.end() - 1);
+   for (int v = 0; v < n; v++) {
+      if (labels.getPath(v) != -1) {
+         children[next[g.getEdgeOrig(labels.getPath(v))]++] = v;
+      }
+   }
+}
+
+/**
+ * @brief After a drivingDijkstraAll, recomputes the driving times that change when the tree edge into root is avoided, without
+ * searching again from the source. Only the subtree of root can change: each of its slots starts from its best edge coming from
+ * outside the subtree, and a Dijkstra restricted to the subtree settles them. Every other slot keeps the labels of ctx.
+ * Total complexity is O((S+F)logS) where S is the size of the subtree and F the number of edges into it.
+ *
+ * @tparam T
+ * @param g graph
+ * @param ctx search state holding the labels of drivingDijkstraAll, left unchanged
+ * @param childBegin children of every slot in the driving tree, from getDrivingTreeChildren
+ * @param children
+ * @param root slot whose tree edge is avoided
+ * @param restrictions avoided nodes and edges, including the tree edge into root
+ * @param repaired used to return the labels of the subtree; its visited slots are the subtree, unreached ones keep an infinite distance
+ * @param subtree used to return the slots of the subtree, in the order they were settled, the unreached ones last
+ */
+template <class T>
+void repairDrivingTree(const CsrGraph<T>& g, const SearchContext& ctx, const std::vector<int>& childBegin, const std::vector<int>& children, int root, const SearchRestrictions& restrictions, SearchLabels& repaired, std::vector<int>& subtree) {
+   const SearchLabels& labels = ctx.getForward();
+   repaired.reset(g.getNumVertex());
+   subtree.clear();
+   subtree.push_back(root);
+   repaired.setVisited(root, true);
+   for (std::size_t i = 0; i < subtree.size(); i++) {
+      for (int c = childBegin[subtree[i]]; c < childBegin[subtree[i] + 1]; c++) {
+         subtree.push_back(children[c]);
+         repaired.setVisited(children[c], true);
+      }
+   }
+   SlotPriorityQueue pq(repaired.getDistArray(), repaired.getQueueIndexArray());
+   for (int v : subtree) {
+      for (int i = g.inBegin(v); i < g.inEnd(v); i++) {
+         int u = g.getInOrig(i);
+         if (repaired.isVisited(u) || labels.getDist(u) == std::numeric_limits<int>::max() || g.getInDrivingTime(i) == std::numeric_limits<int>::max() || restrictions.isEdgeAvoided(g.getInEdge(i))) {
+            continue;
+         }
+         if (repaired.getDist(v) > labels.getDist(u) + g.getInDrivingTime(i)) {
+            repaired.setDist(v, labels.getDist(u) + g.getInDrivingTime(i));
+            repaired.setPath(v, g.getInEdge(i));
+         }
+      }
+      if (repaired.getDist(v) != std::numeric_limits<int>::max()) {
+         pq.insert(v);
+         repaired.setProcessing(v, true);
+      }
+   }
+   std::vector<int> order;
+   order.reserve(subtree.size());
+   while (!pq.empty()) {
+      int v = pq.extractMin();
+      repaired.setProcessing(v, false);
+      order.push_back(v);
+      for (int e = g.outBegin(v); e < g.outEnd(v); e++) {
+         int u = g.getEdgeDest(e);
+         // only unsettled slots of the subtree: queued ones, or ones not reached yet
+         if (!repaired.isVisited(u) || (!repaired.isProcessing(u) && repaired.getDist(u) != std::numeric_limits<int>::max()) || g.getDrivingTime(e) == std::numeric_limits<int>::max() || restrictions.isNodeAvoided(u) || restrictions.isEdgeAvoided(e)) {
+            continue;
+         }
+         if (repaired.getDist(u) > repaired.getDist(v) + g.getDrivingTime(e)) {
+            bool queued = repaired.isProcessing(u);
+            repaired.setDist(u, repaired.getDist(v) + g.getDrivingTime(e));
+            repaired.setPath(u, e);
+            if (queued) {
+               pq.decreaseKey(u);
+            } else {
+               pq.insert(u);
+               repaired.setProcessing(u, true);
+            }
+         }
+      }
+   }
+   for (int v : subtree) {
+      if (repaired.getDist(v) == std::numeric_limits<int>::max()) {
+         order.push_back(v);
+      }
+   }
+   subtree.swap(order);
+}
+
+/**
+ * @brief A* variant of drivingDijkstra, goal-directed by ALT landmark lower bounds on the driving time to the parking candidates
+ * plus their walking time to the destination. It stops as soon as no unsettled vertex can lead to a total time at most equal to
+ * the best one found, instead of waiting for every candidate to be settled. Ties are broken as in drivingDijkstra, preferring
+ * the longer walk. Worst case time complexity is O((V+E)logV) plus O(K) per relaxation, where K is the number of landmarks.
+ * 
+ * @tparam T 
+ * @param g graph
+ * @param ctx search state of the calling thread; the driving edges are left in its forward labels
+ * @param landmarks landmark tables built for g
+ * @param source the slot from which the search will be performed
+ * @param avoidNodes nodes that the path can't go through
+ * @param avoidEdges edges that the path can't go through
+ * @param reacheableWalkingVertices map between the slots of nodes that are candidates to be parking nodes and the time needed to walk to them from source
+ * @param walkingTime used to return the walking time of the best path
+ * @param drivingTime used to return the driving time of the best path
+ * @return int slot of the parking node, or -1 if none was reached
+ */
+template <class T>
+int drivingAStar(const CsrGraph<T>& g, SearchContext& ctx, const Landmarks<T>& landmarks, int source, const std::unordered_set<T>& avoidNodes, const std::unordered_set<std::pair<T, T>, pairHash>& avoidEdges, std::unordered_map<int, int>& reacheableWalkingVertices, int& walkingTime, int& drivingTime) {
+   SearchLabels& labels = ctx.getForward();
+   labels.reset(g.getNumVertex());
+   if (source == -1) {
+       return -1;
+   }
+   SearchRestrictions& restrictions = ctx.getRestrictions();
+   restrictions.set(g, avoidNodes, avoidEdges);
+   std::unordered_map<int, int> targets = reacheableWalkingVertices;
+   targets.erase(source);
+   LandmarkPotential<T> potential(landmarks, targets, false);
+   int sourcePotential = potential.get(source);
+   if (targets.empty() || sourcePotential == -1) {
+       return -1;
+   }
+   int parkingNode = -1;
+   long long parkingNodeCost = std::numeric_limits<int>::max();
+   int numTargets = targets.size();
+   labels.setDist(source, 0);
+   SlotPriorityQueue pq(labels.getDistArray(), labels.getQueueIndexArray());
+   pq.insert(source);
+   while (!pq.empty()) {
+      int v = pq.extractMin();
+      labels.setProcessing(v, false);
+      labels.setVisited(v, true);
+      if ((long long) labels.getDist(v) + sourcePotential > parkingNodeCost) {
+         break;
+      }
+      int vPotential = potential.get(v);
+      auto it = targets.find(v);
+      if (it != targets.end()) {
+         numTargets--;
+         int dist = labels.getDist(v) + sourcePotential - vPotential;
+         long long cost = (long long) it->second + dist;
+         if (cost < parkingNodeCost || (cost == parkingNodeCost && it->second > walkingTime)) {
+            parkingNode = v;
+            parkingNodeCost = cost;
+            walkingTime = it->second;
+            drivingTime = dist;
+         }
+         if (numTargets == 0) {
+            break;
+         }
+      }
+      for (int e = g.outBegin(v); e < g.outEnd(v); e++) {
+         int u = g.getEdgeDest(e);
+         if (g.getDrivingTime(e) == std::numeric_limits<int>::max() || (labels.isVisited(u)&&!labels.isProcessing(u)) || restrictions.isNodeAvoided(u) || restrictions.isEdgeAvoided(e)) {
+           continue;
+         }
+         int uPotential = potential.get(u);
+         if (uPotential == -1) {
            continue;
          }
-         if (u->getDist() > v->getDist() + e->getDrivingTime()) {
-           u->setDist(v->getDist() + e->getDrivingTime());
-           u->setPath(e);
-           if (!u->isVisited()) {
+         int cost = labels.getDist(v) + g.getDrivingTime(e) + uPotential - vPotential;
+         if (labels.getDist(u) > cost) {
+           labels.setDist(u, cost);
+           labels.setPath(u, e);
+           if (!labels.isVisited(u)) {
                pq.insert(u);
-               u->setVisited(true);
-               u->setProcessing(true);
-               visitedVertices.push_back(u);
-           } else if (u->isProcessing()) {
+               labels.setVisited(u, true);
+               labels.setProcessing(u, true);
+           } else {
                pq.decreaseKey(u);
            }
          }
       }
    }
-   cleanUpVisitedAndDist(visitedVertices);
    return parkingNode;
 }
 
@@ -142,31 +440,258 @@ Vertex<T>* drivingDijkstra(const Graph<T>& g, Vertex<T>* source, const std::unor
  * @brief After driving and walking Dijkstra are performed, this function fetches the best path in O(V) time complexity where V is the number of vertices in the graph.
  * 
  * @tparam T 
- * @param parkingNode node where the user parks and starts walking
+ * @param g graph where both Dijkstras were performed
+ * @param ctx search state holding the driving (forward) and walking (backward) edges
+ * @param parkingNode slot where the user parks and starts walking
  * @param orderedIds used to return the ordered ids of nodes in the path
  */
 template <class T> 
-void getDrivingAndWalkingPath(Vertex<T>* parkingNode, std::list<T>& orderedIds) {
-    if (parkingNode == nullptr) {
+void getDrivingAndWalkingPath(const CsrGraph<T>& g, const SearchContext& ctx, int parkingNode, std::list<T>& orderedIds) {
+    if (parkingNode == -1) {
         orderedIds = {};
         return;
     }
-    Edge<T>* aux_edge = parkingNode->getWalkingPath();
-    while (aux_edge != nullptr) {
-        orderedIds.push_back(aux_edge->getDest()->getId());
-        aux_edge = aux_edge->getDest()->getWalkingPath();
+    int aux_edge = ctx.getBackward().getPath(parkingNode);
+    while (aux_edge != -1) {
+        orderedIds.push_back(g.getId(g.getEdgeDest(aux_edge)));
+        aux_edge = ctx.getBackward().getPath(g.getEdgeDest(aux_edge));
     }
-    getDrivingPath(parkingNode, orderedIds);
+    getDrivingPath(g, ctx.getForward(), parkingNode, orderedIds);
+}
+
+/**
+ * @brief Finds the same best drive-park-walk route as calculateEnvironmentallyFriendlyPath with a single search, over a
+ * graph of two layers: a driving layer over the driving times, a walking layer over the walking times, and zero-cost
+ * transfer arcs from the driving to the walking layer at every parking node other than source and dest.
+ *
+ * Driving states have one label per slot, kept in the forward labels of ctx. A walking state carries the total time and the
+ * walking time spent so far, and a slot keeps every walking label not beaten on both, since a slower label that walked less
+ * may be the only one still allowed to reach dest within maxWalkTime. Labels are settled by total time, and by the longest
+ * walk among equal totals, so the first walking label of dest settled is the route calculateEnvironmentallyFriendlyPath
+ * picks and the search stops there. The avoid rules are those of walkingReverseDijsktra and drivingDijkstra: dest may be
+ * in avoid_nodes, and walking segments are checked in the walking direction. Among routes of equal total and walking
+ * time, the driving and walking segments may be other ones of the same times.
+ *
+ * Without a walking limit this beats the two searches of calculateEnvironmentallyFriendlyPath, which then walk from dest
+ * to the whole graph and drive to every parking node. With a short limit it is slower, since every parking node driven
+ * past starts a walk, while the reverse walking search only covers the few vertices around dest.
+ * Total time complexity is O(L(log L + D)) where L is the number of labels created, O(V+E) unless many parking nodes trade
+ * walking time for total time, and D is the largest number of labels of a slot.
+ *
+ * @tparam T
+ * @param g
+ * @param ctx search state of the calling thread; the driving edges are left in its forward labels
+ * @param source slot where the path starts
+ * @param dest slot where the path ends
+ * @param maxWalkTime maximum walking time allowed
+ * @param avoid_nodes nodes that the path can't go through
+ * @param avoid_edges edges that the path can't go through
+ * @param path used to return the best path as a list of ordered IDs
+ * @param parkingNodeId used to return the ID of the node where the user should park
+ * @param walkingTime used to return the walking time of the best path
+ * @param drivingTime used to return the driving time of the best path
+ * @return int is 0 if a path was found, -1 otherwise
+ */
+template <class T>
+int calculateLayeredEnvironmentallyFriendlyPath(const CsrGraph<T>& g, SearchContext& ctx, int source, int dest, const int maxWalkTime, const std::unordered_set<T>& avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash>& avoid_edges, std::list<T>& path, T& parkingNodeId, int& walkingTime, int& drivingTime) {
+    path = {};
+    if (source == -1 || dest == -1) {
+        return -1;
+    }
+    SearchRestrictions& restrictions = ctx.getRestrictions();
+    restrictions.set(g, avoid_nodes, avoid_edges);
+    struct WalkingLabel {
+        long long total;
+        int walk;
+        int slot;
+        int parent;       // previous walking label, -1 at the parking node
+        int nextAtSlot;   // previous label created at the same slot, -1 if none
+        bool dominated;
+    };
+    // Heap of walking labels, by total time and then by the longest walk
+    std::vector<WalkingLabel> labels;
+    auto later = [&labels](int a, int b) {
+        return labels[a].total != labels[b].total ? labels[a].total > labels[b].total : labels[a].walk < labels[b].walk;
+    };
+    std::priority_queue<int, std::vector<int>, decltype(later)> walkingQueue(later);
+    // The backward labels hold, in their path, the last walking label created at each slot
+    SearchLabels& heads = ctx.getBackward();
+    heads.reset(g.getNumVertex());
+
+    // Without a walking limit a label that walked less has nothing left to offer once its total is beaten
+    const bool unlimitedWalk = maxWalkTime == std::numeric_limits<int>::max();
+
+    // Adds the walking label (total, walk) at slot unless one of its labels is at least as good
+    auto addWalkingLabel = [&](int slot, long long total, int walk, int parent) {
+        int head = heads.getPath(slot);
+        for (int l = head; l != -1; l = labels[l].nextAtSlot) {
+            const WalkingLabel& other = labels[l];
+            if (other.total <= total && (unlimitedWalk || other.walk <= walk) && (other.total < total || other.walk >= walk)) {
+                return;
+            }
+        }
+        for (int l = head; l != -1; l = labels[l].nextAtSlot) {
+            WalkingLabel& other = labels[l];
+            if (total <= other.total && (unlimitedWalk || walk <= other.walk) && (total < other.total || walk > other.walk)) {
+                other.dominated = true;
+            }
+        }
+        labels.push_back({total, walk, slot, parent, head, false});
+        heads.setPath(slot, labels.size() - 1);
+        walkingQueue.push(labels.size() - 1);
+    };
+
+    // Settles the walking labels that come before a driving state at time limit; returns the label reaching dest, or -1
+    auto settleWalkingLabels = [&](long long limit) {
+        while (!walkingQueue.empty()) {
+            int l = walkingQueue.top();
+            if (labels[l].total > limit || (labels[l].total == limit && labels[l].walk == 0)) {
+                return -1;
+            }
+            walkingQueue.pop();
+            if (labels[l].dominated) {
+                continue;
+            }
+            int v = labels[l].slot;
+            if (v == dest) {
+                return l;
+            }
+            for (int e = g.outBegin(v); e < g.outEnd(v); e++) {
+                int u = g.getEdgeDest(e);
+                int time = g.getWalkingTime(e);
+                if (time == std::numeric_limits<int>::max() || time > maxWalkTime - labels[l].walk || (u != dest && restrictions.isNodeAvoided(u)) || restrictions.isEdgeAvoided(e)) {
+                    continue;
+                }
+                addWalkingLabel(u, labels[l].total + time, labels[l].walk + time, l);
+            }
+        }
+        return -1;
+    };
+
+    SearchLabels& driving = ctx.getForward();
+    driving.reset(g.getNumVertex());
+    driving.setDist(source, 0);
+    SlotPriorityQueue pq(driving.getDistArray(), driving.getQueueIndexArray());
+    pq.insert(source);
+    int found = -1;
+    while (found == -1 && !pq.empty()) {
+        int v = pq.extractMin();
+        driving.setProcessing(v, false);
+        found = settleWalkingLabels(driving.getDist(v));
+        if (found != -1) {
+            break;
+        }
+        if (g.getParking(v) && v != source && v != dest) {
+            addWalkingLabel(v, driving.getDist(v), 0, -1);
+        }
+        for (int e = g.outBegin(v); e < g.outEnd(v); e++) {
+            int u = g.getEdgeDest(e);
+            if (g.getDrivingTime(e) == std::numeric_limits<int>::max() || (driving.isVisited(u)&&!driving.isProcessing(u)) || restrictions.isNodeAvoided(u) || restrictions.isEdgeAvoided(e)) {
+                continue;
+            }
+            if (driving.getDist(u) > driving.getDist(v) + g.getDrivingTime(e)) {
+                driving.setDist(u, driving.getDist(v) + g.getDrivingTime(e));
+                driving.setPath(u, e);
+                if (!driving.isVisited(u)) {
+                    pq.insert(u);
+                    driving.setVisited(u, true);
+                    driving.setProcessing(u, true);
+                } else if (driving.isProcessing(u)) {
+                    pq.decreaseKey(u);
+                }
+            }
+        }
+    }
+    if (found == -1) {
+        found = settleWalkingLabels(std::numeric_limits<long long>::max());
+    }
+    if (found == -1) {
+        return -1;
+    }
+    int parking = found;
+    for (; labels[parking].parent != -1; parking = labels[parking].parent) {
+        path.push_front(g.getId(labels[parking].slot));
+    }
+    int parkingNode = labels[parking].slot;
+    getDrivingPath(g, driving, parkingNode, path);
+    parkingNodeId = g.getId(parkingNode);
+    walkingTime = labels[found].walk;
+    drivingTime = driving.getDist(parkingNode);
+    return 0;
+}
+
+/**
+ * @brief Finds the best drive-park-walk route from source to dest without restrictions by reading the all-pairs tables
+ * instead of searching: every parking node other than source and dest within maxWalkTime of dest is weighed by its driving
+ * time from source plus its walking time to dest, and ties keep preferring the longer walk, as drivingDijkstra does. The
+ * times are those calculateEnvironmentallyFriendlyPath finds; among parking nodes of equal times the one with the lowest
+ * slot is picked, and the paths may be other ones of the same times.
+ * Total time complexity is O(V + P), where P is the number of edges of the route.
+ *
+ * @tparam T
+ * @param allPairs all-pairs tables of the graph where the path is calculated
+ * @param source slot where the path starts
+ * @param dest slot where the path ends
+ * @param maxWalkTime maximum walking time allowed
+ * @param path used to return the best path as a list of ordered IDs
+ * @param parkingNodeId used to return the ID of the node where the user should park
+ * @param walkingTime used to return the walking time of the best path
+ * @param drivingTime used to return the driving time of the best path
+ * @return int is 0 if a path was found, -1 otherwise
+ */
+template <class T>
+int tabulatedEnvironmentallyFriendlyPath(const AllPairs<T>& allPairs, int source, int dest, const int maxWalkTime, std::list<T>& path, T& parkingNodeId, int& walkingTime, int& drivingTime) {
+    path = {};
+    if (source == -1 || dest == -1) {
+        return -1;
+    }
+    const CsrGraph<T>& g = allPairs.getGraph();
+    int parkingNode = -1;
+    long long parkingNodeCost = std::numeric_limits<int>::max();
+    for (int v = 0; v < g.getNumVertex(); v++) {
+        if (!g.getParking(v) || v == source || v == dest) {
+            continue;
+        }
+        int walk = allPairs.getTime(AllPairs<T>::WALKING, v, dest);
+        int drive = allPairs.getTime(AllPairs<T>::DRIVING, source, v);
+        if (walk == -1 || walk > maxWalkTime || drive == -1) {
+            continue;
+        }
+        long long cost = (long long) walk + drive;
+        if (cost < parkingNodeCost || (cost == parkingNodeCost && walk > walkingTime)) {
+            parkingNode = v;
+            parkingNodeCost = cost;
+            walkingTime = walk;
+            drivingTime = drive;
+        }
+    }
+    if (parkingNode == -1) {
+        return -1;
+    }
+    parkingNodeId = g.getId(parkingNode);
+    std::list<T> walkingPath;
+    allPairs.getPath(AllPairs<T>::DRIVING, source, parkingNode, path);
+    allPairs.getPath(AllPairs<T>::WALKING, parkingNode, dest, walkingPath);
+    walkingPath.pop_front();
+    path.splice(path.end(), walkingPath);
+    return 0;
 }
 
 /**
  * @brief Performs a walking and a driving Dijkstra to find the best path from source to dest that includes driving and walking segments.
+ * With a walking index covering the query, the walking Dijkstra is replaced by reading the candidates of dest from it.
+ * With landmarks, the driving Dijkstra is replaced by drivingAStar, which picks the same parking node and times, though the
+ * driving path may be another one of the same time.
+ * Without a walking limit, the route is found by calculateLayeredEnvironmentallyFriendlyPath instead, with the same
+ * walking and driving times, though the walking path may be another one of the same time.
+ * With all-pairs tables and no restrictions, the route is read from them by tabulatedEnvironmentallyFriendlyPath.
  * Total time complexity is O((V+E)logV) where V is the number of vertices and E is the number of edges in the graph.
  * 
  * @tparam T 
  * @param g 
- * @param source vertex where the path starts
- * @param dest vertex where the path ends
+ * @param ctx search state of the calling thread
+ * @param source slot where the path starts
+ * @param dest slot where the path ends
  * @param maxWalkTime maximum walking distance allowed
  * @param avoid_nodes nodes that the path can't go through
  * @param avoid_edges edges that the path can't go through
@@ -174,26 +699,39 @@ void getDrivingAndWalkingPath(Vertex<T>* parkingNode, std::list<T>& orderedIds)
  * @param parkingNodeId used to return the ID of the node where the user should park
  * @param walkingTime used to return the walking time of the best path
  * @param drivingTime used to return the driving time of the best path
+ * @param walkingIndex parking candidates of every vertex, read instead of running the walking search when it covers the query, or nullptr
+ * @param landmarks landmark tables built for g, used to direct the driving search, or nullptr
+ * @param allPairs all-pairs tables of g, read instead of searching when there are no restrictions, or nullptr
  * @return int is 0 if a path was found, -1 otherwise
  */
 template <class T>
-int calculateEnvironmentallyFriendlyPath(const Graph<T>& g, Vertex<T>* source, Vertex<T>* dest, const int maxWalkTime, const std::unordered_set<T>& avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash>& avoid_edges, std::list<T>& path, T& parkingNodeId, int& walkingTime, int& drivingTime) {
-    std::unordered_map<Vertex<T>*, double> reacheableWalkingVertices = {};
-    std::vector<Vertex<T>*> visitedVertices = {};
-    int err = walkingReverseDijsktra(g, dest, source, maxWalkTime, avoid_nodes, avoid_edges, reacheableWalkingVertices, visitedVertices);
+int calculateEnvironmentallyFriendlyPath(const CsrGraph<T>& g, SearchContext& ctx, int source, int dest, const int maxWalkTime, const std::unordered_set<T>& avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash>& avoid_edges, std::list<T>& path, T& parkingNodeId, int& walkingTime, int& drivingTime, const WalkingIndex<T>* walkingIndex = nullptr, const Landmarks<T>* landmarks = nullptr, const AllPairs<T>* allPairs = nullptr) {
+    if (allPairs != nullptr && avoid_nodes.empty() && avoid_edges.empty()) {
+        return tabulatedEnvironmentallyFriendlyPath(*allPairs, source, dest, maxWalkTime, path, parkingNodeId, walkingTime, drivingTime);
+    }
+    if (maxWalkTime == std::numeric_limits<int>::max()) {
+        return calculateLayeredEnvironmentallyFriendlyPath(g, ctx, source, dest, maxWalkTime, avoid_nodes, avoid_edges, path, parkingNodeId, walkingTime, drivingTime);
+    }
+    std::unordered_map<int, int> reacheableWalkingVertices = {};
+    bool indexed = walkingIndex != nullptr && walkingIndex->covers(dest, maxWalkTime, avoid_nodes, avoid_edges);
+    int err = indexed ? walkingIndex->getReacheableParking(dest, source, maxWalkTime, reacheableWalkingVertices) : walkingReverseDijsktra(g, ctx, dest, source, maxWalkTime, avoid_nodes, avoid_edges, reacheableWalkingVertices);
     if (err == -1) {
         path = {};
         return -1;
     }
-    Vertex<T>* parkingNode = drivingDijkstra(g, source, avoid_nodes, avoid_edges, reacheableWalkingVertices, walkingTime, drivingTime, visitedVertices);
-    if (parkingNode == nullptr) {
+    int parkingNode = landmarks != nullptr ? drivingAStar(g, ctx, *landmarks, source, avoid_nodes, avoid_edges, reacheableWalkingVertices, walkingTime, drivingTime) : drivingDijkstra(g, ctx, source, avoid_nodes, avoid_edges, reacheableWalkingVertices, walkingTime, drivingTime);
+    if (parkingNode == -1) {
         path = {};
         return -1;
     }
-    parkingNodeId=parkingNode->getId();
+    parkingNodeId = g.getId(parkingNode);
     std::list<T> orderedIds = {};
-    getDrivingAndWalkingPath(parkingNode, orderedIds);
-    cleanUpPaths(visitedVertices);
+    if (indexed) {
+        walkingIndex->getWalkingPath(dest, parkingNode, orderedIds);
+        getDrivingPath(g, ctx.getForward(), parkingNode, orderedIds);
+    } else {
+        getDrivingAndWalkingPath(g, ctx, parkingNode, orderedIds);
+    }
     path = orderedIds;
     return 0;
-}
\ No newline at end of file
+}
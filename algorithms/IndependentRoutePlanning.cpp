@@ -1,44 +1,112 @@
 #pragma once
 
-#include "../utils/RestrictedDijkstra.hpp"
+#include "../utils/BidirectionalDijkstra.hpp"
+#include "../utils/ContractionHierarchy.hpp"
+#include "../utils/AllPairs.hpp"
 #include "../utils/GetDrivingPath.hpp"
 #include <list>
 #include <vector>
 
 /**
- * @brief Calculates the shortest path and an alternative path between two vertices in a graph. The time complexity of the function is O((V + E) log V) for each call to Restricted Dijkstra, 
- *  where V is the number of vertices and E is the number of edges in the graph. Since Restricted Dijkstra is called twice (once for the best path and once for the alternative path), the overall complexity is O(2 * (V + E) log V), which simplifies to O((V + E) log V).
+ * @brief Finds the best path from source to dest that goes through none of the intermediate nodes of bestPath.
+ */
+template <class T>
+void getIndependentAlternative(const CsrGraph<T>& g, SearchContext& ctx, int source, int dest, const std::list<T>& bestPath, std::list<T>& altPath, int& altTime) {
+    std::unordered_set<T> usedNodes;
+    T sourceId = g.getId(source);
+    T destinationId = g.getId(dest);
+
+    for (T nodeId : bestPath) {
+        if (nodeId != sourceId && nodeId != destinationId) {
+            usedNodes.insert(nodeId);
+        }
+    }
+    int meetingNode;
+    altTime = BidirectionalDijkstra(g, ctx, source, dest, usedNodes, {}, meetingNode);
+    getBidirectionalPath(g, ctx, meetingNode, altPath);
+}
+
+/**
+ * @brief Calculates the shortest path and an alternative path between two vertices in a graph. The time complexity of the function is O((V + E) log V) for each call to Bidirectional Dijkstra, 
+ *  where V is the number of vertices and E is the number of edges in the graph. Since Bidirectional Dijkstra is called twice (once for the best path and once for the alternative path), the overall complexity is O(2 * (V + E) log V), which simplifies to O((V + E) log V).
  * 
  * @tparam T The type of the vertex identifiers (e.g., int, string).
  * @param g The graph where the paths are calculated.
- * @param source Pointer to the source vertex.
- * @param dest Pointer to the destination vertex.
+ * @param ctx The search state of the calling thread.
+ * @param source Slot of the source vertex.
+ * @param dest Slot of the destination vertex.
  * @param bestPath Reference to a list where the best path (shortest path) will be stored.
  * @param bestTime Reference to an integer where the time of the best path will be stored.
  * @param altPath Reference to a list where the alternative path will be stored.
  * @param altTime Reference to an integer where the time of the alternative path will be stored.
  */
 template <class T> 
-void IndependentRoutePlanning(Graph<T>& g, Vertex<T>* source, Vertex<T>* dest, std::list<T>& bestPath, int& bestTime, std::list<T>& altPath, int& altTime) {
-    if (source==nullptr || dest==nullptr) {
+void IndependentRoutePlanning(const CsrGraph<T>& g, SearchContext& ctx, int source, int dest, std::list<T>& bestPath, int& bestTime, std::list<T>& altPath, int& altTime) {
+    if (source == -1 || dest == -1) {
         std::cout << "Source or destination can't be null!\n";
         return;
     }
-    std::vector<Vertex<T>*> visitedVertices = {};
-    std::unordered_set<int> usedNodes;
-    bestTime = RestrictedDijkstra(g, source, dest, {}, {{}}, visitedVertices);
-    getDrivingPath(dest, bestPath);
-    cleanUpPaths(visitedVertices);
-    T sourceId = source->getId();
-    T destinationId = dest->getId();
+    int meetingNode;
+    bestTime = BidirectionalDijkstra(g, ctx, source, dest, {}, {}, meetingNode);
+    getBidirectionalPath(g, ctx, meetingNode, bestPath);
+    getIndependentAlternative(g, ctx, source, dest, bestPath, altPath, altTime);
+}
 
-    for (T nodeId : bestPath) {
-        if (nodeId != sourceId && nodeId != destinationId) {
-            usedNodes.insert(nodeId);
+/**
+ * @brief Same as IndependentRoutePlanning, but the best path, which has no restrictions, is found by a Contraction Hierarchies query.
+ * The alternative path avoids the nodes of the best path, so it still uses Bidirectional Dijkstra on the hierarchy's graph.
+ *
+ * @tparam T The type of the vertex identifiers (e.g., int, string).
+ * @param ch The contraction hierarchy built for the graph where the paths are calculated.
+ * @param ctx The search state of the calling thread.
+ * @param source Slot of the source vertex.
+ * @param dest Slot of the destination vertex.
+ * @param bestPath Reference to a list where the best path (shortest path) will be stored.
+ * @param bestTime Reference to an integer where the time of the best path will be stored.
+ * @param altPath Reference to a list where the alternative path will be stored.
+ * @param altTime Reference to an integer where the time of the alternative path will be stored.
+ */
+template <class T>
+void IndependentRoutePlanning(const ContractionHierarchy<T>& ch, SearchContext& ctx, int source, int dest, std::list<T>& bestPath, int& bestTime, std::list<T>& altPath, int& altTime) {
+    if (source == -1 || dest == -1) {
+        std::cout << "Source or destination can't be null!\n";
+        return;
+    }
+    const CsrGraph<T>& g = ch.getGraph();
+    int meetingNode;
+    bestTime = ch.query(ctx, source, dest, meetingNode);
+    bestPath = {};
+    if (meetingNode != -1) {
+        std::vector<int> edges;
+        ch.unpackPath(ctx, meetingNode, edges);
+        bestPath.push_back(g.getId(source));
+        for (int e : edges) {
+            bestPath.push_back(g.getId(g.getEdgeDest(e)));
         }
     }
-    visitedVertices.clear();
-    altTime = RestrictedDijkstra(g, source, dest, usedNodes, {{}}, visitedVertices);
-    getDrivingPath(dest, altPath);
-    cleanUpPaths(visitedVertices);
-}
\ No newline at end of file
+    getIndependentAlternative(g, ctx, source, dest, bestPath, altPath, altTime);
+}
+
+/**
+ * @brief Same as IndependentRoutePlanning, but the best path, which has no restrictions, is read from the all-pairs tables
+ * in O(P) where P is its number of edges. The alternative path still uses Bidirectional Dijkstra on the tables' graph.
+ *
+ * @tparam T The type of the vertex identifiers (e.g., int, string).
+ * @param allPairs The all-pairs tables built for the graph where the paths are calculated.
+ * @param ctx The search state of the calling thread.
+ * @param source Slot of the source vertex.
+ * @param dest Slot of the destination vertex.
+ * @param bestPath Reference to a list where the best path (shortest path) will be stored.
+ * @param bestTime Reference to an integer where the time of the best path will be stored.
+ * @param altPath Reference to a list where the alternative path will be stored.
+ * @param altTime Reference to an integer where the time of the alternative path will be stored.
+ */
+template <class T>
+void IndependentRoutePlanning(const AllPairs<T>& allPairs, SearchContext& ctx, int source, int dest, std::list<T>& bestPath, int& bestTime, std::list<T>& altPath, int& altTime) {
+    if (source == -1 || dest == -1) {
+        std::cout << "Source or destination can't be null!\n";
+        return;
+    }
+    bestTime = allPairs.getPath(AllPairs<T>::DRIVING, source, dest, bestPath);
+    getIndependentAlternative(allPairs.getGraph(), ctx, source, dest, bestPath, altPath, altTime);
+}
@@ -0,0 +1,239 @@
+#pragma once
+
+#include "../utils/CsrGraph.hpp"
+#include "../utils/SlotPriorityQueue.h"
+#include "../utils/SearchContext.hpp"
+#include "../utils/PairHash.hpp"
+#include <algorithm>
+#include <limits>
+#include <list>
+#include <set>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @brief Largest number of routes KShortestRoutePlanning returns.
+ */
+const int maxShortestRoutes = 10;
+
+/**
+ * @brief Runs a reverse Dijkstra from dest over the driving times, leaving in the backward labels of ctx the time from every
+ * slot to dest and the edge that leaves it on its best path. The restrictions are the ones RestrictedDijkstra applies
+ * going forward, so source may be an avoided node; they are left set in ctx. Time complexity is O(log(V)(E+V)).
+ */
+template <class T>
+void drivingReverseTree(const CsrGraph<T>& g, SearchContext& ctx, int source, int dest, const std::unordered_set<T>& avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash>& avoid_edges) {
+    SearchLabels& labels = ctx.getBackward();
+    labels.reset(g.getNumVertex());
+    SearchRestrictions& restrictions = ctx.getRestrictions();
+    restrictions.set(g, avoid_nodes, avoid_edges);
+    labels.setDist(dest, 0);
+    SlotPriorityQueue pq(labels.getDistArray(), labels.getQueueIndexArray());
+    pq.insert(dest);
+    while (!pq.empty()) {
+        int v = pq.extractMin();
+        labels.setProcessing(v, false);
+        // Going forward v is entered, so it must not be avoided unless the path starts there
+        if (v != source && restrictions.isNodeAvoided(v)) {
+            continue;
+        }
+        for (int i = g.inBegin(v); i < g.inEnd(v); i++) {
+            int u = g.getInOrig(i);
+            if (g.getInDrivingTime(i) == std::numeric_limits<int>::max() || (labels.isVisited(u) && !labels.isProcessing(u)) || restrictions.isEdgeAvoided(g.getInEdge(i))) {
+                continue;
+            }
+            int cost = labels.getDist(v) + g.getInDrivingTime(i);
+            if (labels.getDist(u) > cost) {
+                labels.setDist(u, cost);
+                labels.setPath(u, g.getInEdge(i));
+                if (!labels.isVisited(u)) {
+                    pq.insert(u);
+                    labels.setVisited(u, true);
+                    labels.setProcessing(u, true);
+                } else if (labels.isProcessing(u)) {
+                    pq.decreaseKey(u);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Finds the k best loopless driving routes from source to dest, in increasing order of time, with Yen's algorithm.
+ *
+ * The reverse shortest path tree to dest is computed once and shared by every iteration. Each spur search is an A* over the
+ * reduced costs w(v,u) + h(u) - h(v), where h is the exact time to dest read from the tree, so it follows the tree at cost
+ * zero and stops at the first settled vertex whose tree path leaves the root of the spur untouched; the rest of the route
+ * is read from the tree. As in Lawler's variant, a route only spurs from its deviation point onwards, since the earlier
+ * spur nodes were searched when its parent route was taken. Ties are broken by the sequence of slots, so the result is
+ * deterministic. Worst case time complexity is O(K·L·log(V)(E+V)), where L is the number of vertices in a route; in
+ * practice a spur search settles few vertices beyond the spur node.
+ *
+ * @tparam T
+ * @param g graph where the routes are calculated
+ * @param ctx search state of the calling thread; its backward labels are left with the reverse tree
+ * @param source slot where the routes start
+ * @param dest slot where the routes end
+ * @param k number of routes wanted, at most maxShortestRoutes
+ * @param avoid_nodes nodes that no route can go through
+ * @param avoid_edges edges that no route can go through
+ * @param paths used to return the routes as lists of node ids
+ * @param times used to return the driving time of each route
+ * @return int number of routes found, or -1 if source or dest is invalid
+ */
+template <class T>
+int KShortestRoutePlanning(const CsrGraph<T>& g, SearchContext& ctx, int source, int dest, int k, const std::unordered_set<T>& avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash>& avoid_edges, std::vector<std::list<T>>& paths, std::vector<int>& times) {
+    paths = {};
+    times = {};
+    if (source == -1 || dest == -1) {
+        return -1;
+    }
+    k = std::min(k, maxShortestRoutes);
+    if (k < 1 || (source != dest && avoid_nodes.find(g.getId(dest)) != avoid_nodes.end())) {
+        return 0;
+    }
+    drivingReverseTree(g, ctx, source, dest, avoid_nodes, avoid_edges);
+    const SearchLabels& tree = ctx.getBackward();
+    const SearchRestrictions& restrictions = ctx.getRestrictions();
+    if (tree.getDist(source) == std::numeric_limits<int>::max()) {
+        return 0;
+    }
+
+    struct Route {
+        std::vector<int> slots;
+        std::vector<int> prefix;    // driving time from source to each slot
+        int deviation;              // index of the spur node the route was found from
+        bool operator<(const Route& other) const {
+            return prefix.back() != other.prefix.back() ? prefix.back() < other.prefix.back() : slots < other.slots;
+        }
+    };
+    // Follows the tree from v, appending the rest of its best path to dest
+    auto appendTreePath = [&](Route& route, int v) {
+        for (int e = tree.getPath(v); e != -1; e = tree.getPath(g.getEdgeDest(e))) {
+            route.slots.push_back(g.getEdgeDest(e));
+            route.prefix.push_back(route.prefix.back() + g.getDrivingTime(e));
+        }
+    };
+
+    std::vector<Route> accepted;
+    std::set<Route> candidates;
+    Route best = {{source}, {0}, 0};
+    appendTreePath(best, source);
+    candidates.insert(best);
+
+    // Slots of the current root are banned while stamp == generation; clean tells whether the tree path of a slot avoids them
+    int n = g.getNumVertex();
+    std::vector<int> bannedStamp(n, 0), cleanStamp(n, 0), pending;
+    std::vector<char> clean(n, 0);
+    int generation = 0;
+    auto isClean = [&](int v) {
+        pending.clear();
+        bool value;
+        while (true) {
+            if (cleanStamp[v] == generation) {
+                value = clean[v];
+                break;
+            }
+            if (bannedStamp[v] == generation) {
+                value = false;
+                break;
+            }
+            pending.push_back(v);
+            if (v == dest) {
+                value = true;
+                break;
+            }
+            v = g.getEdgeDest(tree.getPath(v));
+        }
+        for (int u : pending) {
+            cleanStamp[u] = generation;
+            clean[u] = value;
+        }
+        return value;
+    };
+
+    SearchLabels& labels = ctx.getForward();
+    std::vector<int> bannedNext;
+    while ((int) accepted.size() < k && !candidates.empty()) {
+        accepted.push_back(*candidates.begin());
+        candidates.erase(candidates.begin());
+        if ((int) accepted.size() == k) {
+            break;
+        }
+        const Route& route = accepted.back();
+        for (std::size_t j = route.deviation; j + 1 < route.slots.size(); j++) {
+            int spur = route.slots[j];
+            generation++;
+            for (std::size_t i = 0; i <= j; i++) {
+                bannedStamp[route.slots[i]] = generation;
+            }
+            // Routes already taken with the same root leave the spur node through the edges that can't be used again
+            bannedNext.clear();
+            for (const Route& other : accepted) {
+                if (other.slots.size() > j + 1 && std::equal(route.slots.begin(), route.slots.begin() + j + 1, other.slots.begin())) {
+                    bannedNext.push_back(other.slots[j + 1]);
+                }
+            }
+
+            labels.reset(n);
+            labels.setDist(spur, 0);
+            SlotPriorityQueue pq(labels.getDistArray(), labels.getQueueIndexArray());
+            pq.insert(spur);
+            labels.setVisited(spur, true);
+            int reached = -1;
+            while (!pq.empty()) {
+                int v = pq.extractMin();
+                labels.setProcessing(v, false);
+                if (v != spur && isClean(v)) {
+                    reached = v;
+                    break;
+                }
+                for (int e = g.outBegin(v); e < g.outEnd(v); e++) {
+                    int u = g.getEdgeDest(e);
+                    if (g.getDrivingTime(e) == std::numeric_limits<int>::max() || tree.getDist(u) == std::numeric_limits<int>::max() || bannedStamp[u] == generation || (labels.isVisited(u) && !labels.isProcessing(u)) || restrictions.isNodeAvoided(u) || restrictions.isEdgeAvoided(e)) {
+                        continue;
+                    }
+                    if (v == spur && std::find(bannedNext.begin(), bannedNext.end(), u) != bannedNext.end()) {
+                        continue;
+                    }
+                    int cost = labels.getDist(v) + g.getDrivingTime(e) + tree.getDist(u) - tree.getDist(v);
+                    if (labels.getDist(u) > cost) {
+                        labels.setDist(u, cost);
+                        labels.setPath(u, e);
+                        if (!labels.isVisited(u)) {
+                            pq.insert(u);
+                            labels.setVisited(u, true);
+                            labels.setProcessing(u, true);
+                        } else if (labels.isProcessing(u)) {
+                            pq.decreaseKey(u);
+                        }
+                    }
+                }
+            }
+            if (reached == -1) {
+                continue;
+            }
+
+            Route candidate = {std::vector<int>(route.slots.begin(), route.slots.begin() + j + 1), std::vector<int>(route.prefix.begin(), route.prefix.begin() + j + 1), (int) j};
+            std::vector<int> spurEdges;
+            for (int e = labels.getPath(reached); e != -1; e = labels.getPath(g.getEdgeOrig(e))) {
+                spurEdges.push_back(e);
+            }
+            for (auto it = spurEdges.rbegin(); it != spurEdges.rend(); ++it) {
+                candidate.slots.push_back(g.getEdgeDest(*it));
+                candidate.prefix.push_back(candidate.prefix.back() + g.getDrivingTime(*it));
+            }
+            appendTreePath(candidate, reached);
+            candidates.insert(candidate);
+        }
+    }
+
+    for (const Route& route : accepted) {
+        paths.emplace_back();
+        for (int v : route.slots) {
+            paths.back().push_back(g.getId(v));
+        }
+        times.push_back(route.prefix.back());
+    }
+    return accepted.size();
+}
@@ -1,7 +1,9 @@
 #pragma once
 
+#include "../utils/BidirectionalDijkstra.hpp"
 #include "../utils/RestrictedDijkstra.hpp"
 #include "../utils/GetDrivingPath.hpp"
+#include "../utils/MultiLevelOverlay.hpp"
 #include <list>
 
 /**
@@ -9,49 +11,110 @@
  * - Nodes to avoid.
  * - Edges to avoid.
  * - An optional intermediate node that must be included in the path.
- * The time complexity of the function is O((V + E) log V) for each call to Restricted Dijkstra, 
+ * The time complexity of the function is O((V + E) log V) for each call to Bidirectional Dijkstra, 
  * where V is the number of vertices and E is the number of edges in the graph.
- * If the include_node is specified, Restricted Dijkstra is called twice, resulting in an overall complexity of O(2 * (V + E) log V), 
+ * If the include_node is specified, Bidirectional Dijkstra is called twice, resulting in an overall complexity of O(2 * (V + E) log V), 
  * which simplifies to O((V + E) log V).
+ * With landmarks, each search is an A* over their lower bounds instead, which settles far fewer vertices; among routes
+ * of equal time it may return another one than Bidirectional Dijkstra.
  * 
  * @tparam T The type of the vertex identifiers (e.g., int, string).
  * @param g The graph where the path is calculated.
- * @param source Pointer to the source vertex.
- * @param dest Pointer to the destination vertex.
+ * @param ctx The search state of the calling thread.
+ * @param source Slot of the source vertex.
+ * @param dest Slot of the destination vertex.
  * @param avoid_nodes A set of nodes that must be avoided in the path.
  * @param avoid_edges A set of edges that must be avoided in the path.
- * @param include_node Pointer to an intermediate node that must be included in the path (can be nullptr if not required).
+ * @param include_node Slot of an intermediate node that must be included in the path (-1 if not required).
  * @param path Reference to a list where the resulting path will be stored.
+ * @param landmarks Landmark tables built for g, or nullptr to search with Bidirectional Dijkstra.
  * 
  * @return int The total time of the path (sum of weights), or -1 if no valid path is found.
  */
 template <class T> 
-int RestrictedRoutePlanning(Graph<T>& g, Vertex<T>* source, Vertex<T>* dest, std::unordered_set<T> avoid_nodes, std::unordered_set<std::pair<T,T>, pairHash> avoid_edges, Vertex<T>* include_node, std::list<T>& path) {
-    std::vector<Vertex<T>*> visitedVertices = {};
+int RestrictedRoutePlanning(const CsrGraph<T>& g, SearchContext& ctx, int source, int dest, std::unordered_set<T> avoid_nodes, std::unordered_set<std::pair<T,T>, pairHash> avoid_edges, int include_node, std::list<T>& path, const Landmarks<T>* landmarks = nullptr) {
     int time;
-    if (include_node != nullptr) {
-        time = RestrictedDijkstra(g, include_node, dest, avoid_nodes, avoid_edges, visitedVertices);
+    int meetingNode;
+    // A* leaves the path in the forward labels, Bidirectional Dijkstra splits it at meetingNode
+    auto search = [&](int from, int to) {
+        if (landmarks != nullptr) {
+            return RestrictedAStar(g, ctx, *landmarks, from, to, avoid_nodes, avoid_edges);
+        }
+        return BidirectionalDijkstra(g, ctx, from, to, avoid_nodes, avoid_edges, meetingNode);
+    };
+    auto readPath = [&](int to) {
+        if (landmarks != nullptr) {
+            getDrivingPath(g, ctx.getForward(), to, path);
+        } else {
+            getBidirectionalPath(g, ctx, meetingNode, path);
+        }
+    };
+    if (include_node != -1) {
+        time = search(include_node, dest);
+        if (time == -1) {
+            path.clear();
+            return -1;
+        }
+        readPath(dest);
+        path.pop_front();
+        int time2 = search(source, include_node);
+        if (time2 == -1) {
+            return -1;
+        }
+        time += time2;
+        readPath(include_node);
+    } else {
+        time = search(source, dest);
+        if (time == -1) {
+            return -1;
+        }
+        readPath(dest);
+    }
+    return time;
+}
+
+/**
+ * @brief Same as RestrictedRoutePlanning, but the searches run on a multi-level overlay. The overlay is customized once for
+ * avoid_nodes and avoid_edges, recomputing only the cells they touch, and both searches of an include_node query share it.
+ *
+ * @tparam T The type of the vertex identifiers (e.g., int, string).
+ * @param overlay The overlay built for the graph where the path is calculated.
+ * @param ctx The search state of the calling thread.
+ * @param source Slot of the source vertex.
+ * @param dest Slot of the destination vertex.
+ * @param avoid_nodes A set of nodes that must be avoided in the path.
+ * @param avoid_edges A set of edges that must be avoided in the path.
+ * @param include_node Slot of an intermediate node that must be included in the path (-1 if not required).
+ * @param path Reference to a list where the resulting path will be stored.
+ *
+ * @return int The total time of the path (sum of weights), or -1 if no valid path is found.
+ */
+template <class T>
+int RestrictedRoutePlanning(const MultiLevelOverlay<T>& overlay, SearchContext& ctx, int source, int dest, std::unordered_set<T> avoid_nodes, std::unordered_set<std::pair<T,T>, pairHash> avoid_edges, int include_node, std::list<T>& path) {
+    OverlayMetric metric;
+    overlay.customize(ctx, avoid_nodes, avoid_edges, metric);
+    int time;
+    int meetingNode;
+    if (include_node != -1) {
+        time = overlay.query(ctx, metric, include_node, dest, avoid_nodes, avoid_edges, meetingNode);
         if (time == -1) {
             path.clear();
             return -1;
         }
-        getDrivingPath(dest, path);
+        overlay.getPath(ctx, metric, include_node, dest, avoid_nodes, avoid_edges, meetingNode, path);
         path.pop_front();
-        cleanUpPaths(visitedVertices);
-        int time2 = RestrictedDijkstra(g, source, include_node, avoid_nodes, avoid_edges, visitedVertices);
+        int time2 = overlay.query(ctx, metric, source, include_node, avoid_nodes, avoid_edges, meetingNode);
         if (time2 == -1) {
             return -1;
         }
         time += time2;
-        getDrivingPath(include_node, path);
-        cleanUpPaths(visitedVertices);
+        overlay.getPath(ctx, metric, source, include_node, avoid_nodes, avoid_edges, meetingNode, path);
     } else {
-        time = RestrictedDijkstra(g, source, dest, avoid_nodes, avoid_edges, visitedVertices);
+        time = overlay.query(ctx, metric, source, dest, avoid_nodes, avoid_edges, meetingNode);
         if (time == -1) {
             return -1;
         }
-        getDrivingPath(dest, path);
-        cleanUpPaths(visitedVertices);
+        overlay.getPath(ctx, metric, source, dest, avoid_nodes, avoid_edges, meetingNode, path);
     }
     return time;
 }
\ No newline at end of file
@@ -0,0 +1,267 @@
+#pragma once
+
+#include "../utils/CsrGraph.hpp"
+#include "../utils/SlotPriorityQueue.h"
+#include "../utils/SearchContext.hpp"
+#include "../utils/BidirectionalDijkstra.hpp"
+#include "../utils/PairHash.hpp"
+#include <algorithm>
+#include <limits>
+#include <list>
+#include <tuple>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @brief Largest number of alternatives ViaNodeRoutePlanning returns.
+ */
+const int maxViaAlternatives = 10;
+
+/**
+ * @brief Runs a Dijkstra over the driving times from root, over the out-edges, or over the in-edges if reverse is set, so the
+ * labels hold the times to root. Once target is settled, the search goes on until the time reaches (1 + maxStretch) times
+ * the time of target. The restrictions are applied as RestrictedDijkstra does going forward from the source, which is root
+ * or, if reverse is set, target. Time complexity is O(log(V)(E+V)).
+ *
+ * @param labels labels of the search, holding the edge that reaches each slot, or that leaves it if reverse is set
+ * @param restrictions avoided nodes and edges
+ * @param order used to return the settled slots in the order they were settled
+ */
+template <class T>
+void drivingSearchTree(const CsrGraph<T>& g, SearchLabels& labels, int root, int target, double maxStretch, bool reverse, const SearchRestrictions& restrictions, std::vector<int>& order) {
+    labels.reset(g.getNumVertex());
+    labels.setDist(root, 0);
+    labels.setVisited(root, true);
+    SlotPriorityQueue pq(labels.getDistArray(), labels.getQueueIndexArray());
+    pq.insert(root);
+    long long bound = std::numeric_limits<long long>::max();
+    order.clear();
+    while (!pq.empty()) {
+        int v = pq.extractMin();
+        labels.setProcessing(v, false);
+        if (labels.getDist(v) > bound) {
+            break;
+        }
+        order.push_back(v);
+        if (v == target) {
+            bound = (long long) (labels.getDist(v) * (1 + maxStretch));
+        }
+        // Going forward v is entered, so it must not be avoided unless the path starts there
+        if (reverse && v != target && restrictions.isNodeAvoided(v)) {
+            continue;
+        }
+        int begin = reverse ? g.inBegin(v) : g.outBegin(v);
+        int end = reverse ? g.inEnd(v) : g.outEnd(v);
+        for (int i = begin; i < end; i++) {
+            int u = reverse ? g.getInOrig(i) : g.getEdgeDest(i);
+            int time = reverse ? g.getInDrivingTime(i) : g.getDrivingTime(i);
+            int e = reverse ? g.getInEdge(i) : i;
+            if (time == std::numeric_limits<int>::max() || (labels.isVisited(u) && !labels.isProcessing(u)) || (!reverse && restrictions.isNodeAvoided(u)) || restrictions.isEdgeAvoided(e)) {
+                continue;
+            }
+            int cost = labels.getDist(v) + time;
+            if (labels.getDist(u) > cost) {
+                labels.setDist(u, cost);
+                labels.setPath(u, e);
+                if (!labels.isVisited(u)) {
+                    pq.insert(u);
+                    labels.setVisited(u, true);
+                    labels.setProcessing(u, true);
+                } else if (labels.isProcessing(u)) {
+                    pq.decreaseKey(u);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Finds the best driving route from source to dest and up to k alternatives to it, all from one forward search from
+ * source and one backward search to dest.
+ *
+ * Every slot v settled by both searches gives the via route made of the forward tree path to v and the backward tree path
+ * from v. Edges that belong to both trees form plateaus, and every slot of a plateau gives the same route, so each plateau
+ * is weighed once. A via route is admissible when:
+ * - its time is at most (1 + maxStretch) times the best time (bounded stretch);
+ * - it shares at most maxSharing times the best time with the best route and with every alternative taken before it
+ *   (limited sharing);
+ * - its subpath within localOptimality times the best time around v is a shortest path (local optimality), which holds
+ *   without a search when the plateau of v covers it or the two trees bound it from below.
+ * Candidates are ranked by 2·time + shared time with the best route - plateau time, so long plateaus and little sharing come
+ * first, and taken in that order while they are admissible. Ties are broken by slot, so the result is deterministic.
+ * The searches take O(log(V)(E+V)); each candidate costs O(L) to weigh, plus a Dijkstra over the neighbourhood of v when the
+ * trees can't tell whether it's locally optimal, where L is the number of vertices of its route.
+ *
+ * @tparam T
+ * @param g graph where the routes are calculated
+ * @param ctx search state of the calling thread; its labels are left with the two search trees
+ * @param source slot where the routes start
+ * @param dest slot where the routes end
+ * @param k number of alternatives wanted, at most maxViaAlternatives
+ * @param avoid_nodes nodes that no route can go through
+ * @param avoid_edges edges that no route can go through
+ * @param paths used to return the best route followed by the alternatives, as lists of node ids
+ * @param times used to return the driving time of each route
+ * @param maxStretch how much longer than the best route an alternative may be, as a fraction of the best time
+ * @param maxSharing how much of the best time an alternative may share with each route taken before it
+ * @param localOptimality size of the neighbourhood of the via slot that must be a shortest path, as a fraction of the best time
+ * @return int number of routes found, the best one included, or -1 if source or dest is invalid
+ */
+template <class T>
+int ViaNodeRoutePlanning(const CsrGraph<T>& g, SearchContext& ctx, int source, int dest, int k, const std::unordered_set<T>& avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash>& avoid_edges, std::vector<std::list<T>>& paths, std::vector<int>& times, double maxStretch = 0.25, double maxSharing = 0.8, double localOptimality = 0.25) {
+    paths = {};
+    times = {};
+    if (source == -1 || dest == -1) {
+        return -1;
+    }
+    if (source == dest) {
+        paths.push_back({g.getId(source)});
+        times.push_back(0);
+        return 1;
+    }
+    SearchLabels& forward = ctx.getForward();
+    SearchLabels& backward = ctx.getBackward();
+    SearchRestrictions& restrictions = ctx.getRestrictions();
+    restrictions.set(g, avoid_nodes, avoid_edges);
+    std::vector<int> forwardOrder, backwardOrder;
+    drivingSearchTree(g, forward, source, dest, maxStretch, false, restrictions, forwardOrder);
+    auto settled = [](const SearchLabels& labels, int v) { return labels.isVisited(v) && !labels.isProcessing(v); };
+    if (!settled(forward, dest)) {
+        return 0;
+    }
+    drivingSearchTree(g, backward, dest, source, maxStretch, true, restrictions, backwardOrder);
+    long long best = forward.getDist(dest);
+    long long maxTime = (long long) (best * (1 + maxStretch));
+    long long maxShared = (long long) (best * maxSharing);
+    long long radius = (long long) (best * localOptimality);
+
+    // Plateau time before and after each slot, first slot of its plateau, and time shared with the best route before and after it
+    int n = g.getNumVertex();
+    std::vector<int> up(n, 0), down(n, 0), plateau(n, -1), sharedBefore(n, 0), sharedAfter(n, 0);
+    std::vector<char> onBest(n, 0);
+    for (int v = dest; v != source; v = g.getEdgeOrig(forward.getPath(v))) {
+        onBest[v] = 1;
+    }
+    for (int v : forwardOrder) {
+        plateau[v] = v;
+        int e = forward.getPath(v);
+        if (e == -1) {
+            continue;
+        }
+        int u = g.getEdgeOrig(e);
+        if (settled(backward, u) && backward.getPath(u) == e) {
+            up[v] = up[u] + g.getDrivingTime(e);
+            plateau[v] = plateau[u];
+        }
+        sharedBefore[v] = sharedBefore[u] + (onBest[v] ? g.getDrivingTime(e) : 0);
+    }
+    for (int u : backwardOrder) {
+        int e = backward.getPath(u);
+        if (e == -1) {
+            continue;
+        }
+        int v = g.getEdgeDest(e);
+        bool forwardEdge = settled(forward, v) && forward.getPath(v) == e;
+        down[u] = forwardEdge ? down[v] + g.getDrivingTime(e) : 0;
+        sharedAfter[u] = sharedAfter[v] + (forwardEdge && onBest[v] ? g.getDrivingTime(e) : 0);
+    }
+
+    // (rank, slot) of one slot per plateau, off the best route, within the stretch and sharing bounds
+    std::vector<std::tuple<long long, int>> candidates;
+    std::vector<char> plateauTaken(n, 0);
+    for (int v : forwardOrder) {
+        if (v == source || onBest[v] || !settled(backward, v) || plateauTaken[plateau[v]]) {
+            continue;
+        }
+        long long time = (long long) forward.getDist(v) + backward.getDist(v);
+        long long shared = (long long) sharedBefore[v] + sharedAfter[v];
+        if (time > maxTime || shared > maxShared) {
+            continue;
+        }
+        plateauTaken[plateau[v]] = 1;
+        candidates.push_back({2 * time + shared - up[v] - down[v], v});
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    std::vector<std::vector<int>> routes = {{}};      // edges of each route taken
+    std::vector<std::unordered_set<int>> routeEdges(1);
+    for (int v = dest; v != source; v = g.getEdgeOrig(forward.getPath(v))) {
+        routes[0].push_back(forward.getPath(v));
+        routeEdges[0].insert(forward.getPath(v));
+    }
+    std::reverse(routes[0].begin(), routes[0].end());
+    times.push_back(best);
+
+    // The subpath from x to y through v is a shortest path if the plateau of v covers it, or if the trees bound the time
+    // between x and y from below by its time; otherwise a search between them tells
+    SearchContext local;
+    auto isLocallyOptimal = [&](int x, int y, int before, int after, int v) {
+        if (before <= up[v] && after <= down[v]) {
+            return true;
+        }
+        if ((settled(forward, y) && forward.getDist(y) - forward.getDist(x) == before + after) || (settled(backward, x) && backward.getDist(x) - backward.getDist(y) == before + after)) {
+            return true;
+        }
+        int meetingNode;
+        return BidirectionalDijkstra(g, local, x, y, avoid_nodes, avoid_edges, meetingNode) == before + after;
+    };
+    std::vector<int> edges;
+    std::unordered_set<int> slots;
+    for (const auto& candidate : candidates) {
+        if ((int) routes.size() > std::min(k, maxViaAlternatives)) {
+            break;
+        }
+        int v = std::get<1>(candidate);
+        edges.clear();
+        for (int e = forward.getPath(v); e != -1; e = forward.getPath(g.getEdgeOrig(e))) {
+            edges.push_back(e);
+        }
+        std::reverse(edges.begin(), edges.end());
+        for (int e = backward.getPath(v); e != -1; e = backward.getPath(g.getEdgeDest(e))) {
+            edges.push_back(e);
+        }
+        // The two tree paths may meet before v, making a loop
+        slots = {source};
+        bool simple = true;
+        for (int e : edges) {
+            simple = simple && slots.insert(g.getEdgeDest(e)).second;
+        }
+        if (!simple) {
+            continue;
+        }
+        bool limited = true;
+        for (const std::unordered_set<int>& taken : routeEdges) {
+            long long shared = 0;
+            for (int e : edges) {
+                shared += taken.count(e) ? g.getDrivingTime(e) : 0;
+            }
+            limited = limited && shared <= maxShared;
+        }
+        if (!limited) {
+            continue;
+        }
+        // x and y are the closest slots to v at least radius away from it along the route, or its ends
+        int x = v, y = v;
+        while (x != source && forward.getDist(v) - forward.getDist(x) < radius) {
+            x = g.getEdgeOrig(forward.getPath(x));
+        }
+        while (y != dest && backward.getDist(v) - backward.getDist(y) < radius) {
+            y = g.getEdgeDest(backward.getPath(y));
+        }
+        int before = forward.getDist(v) - forward.getDist(x), after = backward.getDist(v) - backward.getDist(y);
+        if (!isLocallyOptimal(x, y, before, after, v)) {
+            continue;
+        }
+        routes.push_back(edges);
+        routeEdges.emplace_back(edges.begin(), edges.end());
+        times.push_back(forward.getDist(v) + backward.getDist(v));
+    }
+
+    for (const std::vector<int>& route : routes) {
+        paths.push_back({g.getId(source)});
+        for (int e : route) {
+            paths.back().push_back(g.getId(g.getEdgeDest(e)));
+        }
+    }
+    return routes.size();
+}
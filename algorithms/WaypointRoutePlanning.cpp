@@ -0,0 +1,276 @@
+#pragma once
+
+#include "../utils/CsrGraph.hpp"
+#include "../utils/SlotPriorityQueue.h"
+#include "../utils/SearchContext.hpp"
+#include "../utils/GetDrivingPath.hpp"
+#include "../utils/PairHash.hpp"
+#include <algorithm>
+#include <limits>
+#include <list>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @brief Largest number of waypoints WaypointRoutePlanning accepts.
+ */
+const int maxWaypoints = 50;
+
+/**
+ * @brief Largest number of waypoints whose order WaypointRoutePlanning optimizes exactly; longer lists are ordered heuristically.
+ */
+const int exactWaypointLimit = 12;
+
+/**
+ * @brief Runs a Dijkstra over the driving times from source that stops once every slot in targets is settled, applying the
+ * restrictions already set in ctx as RestrictedDijkstra does. Time complexity is O(log(V)(E+V)·log(K)) in the worst case,
+ * where K is the number of targets, but the search ends as soon as the farthest target is reached.
+ *
+ * @param ctx search state of the calling thread; the edges used to reach each slot are left in its forward labels
+ * @param targets slots whose times are wanted
+ * @param times used to return the driving time to each target, or -1 if it can't be reached
+ */
+template <class T>
+void drivingOneToMany(const CsrGraph<T>& g, SearchContext& ctx, int source, const std::vector<int>& targets, std::vector<int>& times) {
+    std::vector<int> pending(targets);
+    std::sort(pending.begin(), pending.end());
+    pending.erase(std::unique(pending.begin(), pending.end()), pending.end());
+    int remaining = pending.size();
+    SearchLabels& labels = ctx.getForward();
+    const SearchRestrictions& restrictions = ctx.getRestrictions();
+    labels.reset(g.getNumVertex());
+    labels.setDist(source, 0);
+    labels.setVisited(source, true);
+    SlotPriorityQueue pq(labels.getDistArray(), labels.getQueueIndexArray());
+    pq.insert(source);
+    while (!pq.empty() && remaining > 0) {
+        int v = pq.extractMin();
+        labels.setProcessing(v, false);
+        if (std::binary_search(pending.begin(), pending.end(), v)) {
+            remaining--;
+        }
+        for (int e = g.outBegin(v); e < g.outEnd(v); e++) {
+            int u = g.getEdgeDest(e);
+            if (g.getDrivingTime(e) == std::numeric_limits<int>::max() || (labels.isVisited(u) && !labels.isProcessing(u)) || restrictions.isNodeAvoided(u) || restrictions.isEdgeAvoided(e)) {
+                continue;
+            }
+            int cost = labels.getDist(v) + g.getDrivingTime(e);
+            if (labels.getDist(u) > cost) {
+                labels.setDist(u, cost);
+                labels.setPath(u, e);
+                if (!labels.isVisited(u)) {
+                    pq.insert(u);
+                    labels.setVisited(u, true);
+                    labels.setProcessing(u, true);
+                } else if (labels.isProcessing(u)) {
+                    pq.decreaseKey(u);
+                }
+            }
+        }
+    }
+    times.assign(targets.size(), -1);
+    for (std::size_t j = 0; j < targets.size(); j++) {
+        if (labels.isVisited(targets[j]) && !labels.isProcessing(targets[j])) {
+            times[j] = labels.getDist(targets[j]);
+        }
+    }
+}
+
+/**
+ * @brief Orders the waypoints of a route from source to dest so its total time is the least, given the time of every leg.
+ * Stops 0..m-1 are the waypoints, m is source and m + 1 is dest, and cost(a, b) is the time from stop a to stop b.
+ *
+ * Up to exactWaypointLimit waypoints, the Held-Karp dynamic program over subsets finds the best order in O(2^m·m²).
+ * Beyond that, the order is built by cheapest insertion and improved by or-opt moves (a run of up to three consecutive
+ * waypoints moved elsewhere) and 2-opt moves (a run of waypoints reversed), taking the first move that shortens the route
+ * until none does. Each pass over the moves is O(m²) and the result is a local optimum, not necessarily the best order.
+ *
+ * @param order used to return the waypoints in visiting order
+ */
+template <class Cost>
+void orderWaypoints(int m, const Cost& cost, std::vector<int>& order) {
+    order.clear();
+    const long long infinite = std::numeric_limits<long long>::max() / 4;
+    if (m <= exactWaypointLimit) {
+        // best[mask * m + j] is the least time from source through the waypoints in mask, ending at j
+        std::vector<long long> best(((std::size_t) 1 << m) * m, infinite);
+        std::vector<int> previous(best.size(), -1);
+        for (int j = 0; j < m; j++) {
+            best[((std::size_t) 1 << j) * m + j] = cost(m, j);
+        }
+        for (std::size_t mask = 1; mask < ((std::size_t) 1 << m); mask++) {
+            for (int j = 0; j < m; j++) {
+                long long time = best[mask * m + j];
+                if (!(mask & ((std::size_t) 1 << j)) || time == infinite) {
+                    continue;
+                }
+                for (int i = 0; i < m; i++) {
+                    std::size_t next = mask | ((std::size_t) 1 << i);
+                    if (next != mask && time + cost(j, i) < best[next * m + i]) {
+                        best[next * m + i] = time + cost(j, i);
+                        previous[next * m + i] = j;
+                    }
+                }
+            }
+        }
+        std::size_t full = ((std::size_t) 1 << m) - 1;
+        int last = 0;
+        for (int j = 1; j < m; j++) {
+            if (best[full * m + j] + cost(j, m + 1) < best[full * m + last] + cost(last, m + 1)) {
+                last = j;
+            }
+        }
+        for (std::size_t mask = full; last != -1;) {
+            order.push_back(last);
+            int before = previous[mask * m + last];
+            mask &= ~((std::size_t) 1 << last);
+            last = before;
+        }
+        std::reverse(order.begin(), order.end());
+        return;
+    }
+
+    // Cheapest insertion: the waypoint and position that add the least time go in first
+    std::vector<int> tour = {m, m + 1};
+    std::vector<char> inserted(m, 0);
+    for (int step = 0; step < m; step++) {
+        long long bestIncrease = infinite;
+        int bestStop = -1, bestPosition = -1;
+        for (int w = 0; w < m; w++) {
+            for (std::size_t k = 0; !inserted[w] && k + 1 < tour.size(); k++) {
+                long long increase = cost(tour[k], w) + cost(w, tour[k + 1]) - cost(tour[k], tour[k + 1]);
+                if (increase < bestIncrease) {
+                    bestIncrease = increase;
+                    bestStop = w;
+                    bestPosition = k + 1;
+                }
+            }
+        }
+        tour.insert(tour.begin() + bestPosition, bestStop);
+        inserted[bestStop] = 1;
+    }
+
+    // Waypoints are tour[1..m]; forward[k] and backward[k] are the times of tour[0..k] and of tour[1..k] reversed
+    std::vector<long long> forward(m + 2), backward(m + 2);
+    auto orOpt = [&]() {
+        for (int length = 1; length <= 3; length++) {
+            for (int i = 1; i + length - 1 <= m; i++) {
+                int first = tour[i], last = tour[i + length - 1];
+                long long removed = cost(tour[i - 1], first) + cost(last, tour[i + length]) - cost(tour[i - 1], tour[i + length]);
+                for (int k = 0; k <= m; k++) {
+                    if (k >= i - 1 && k < i + length) {
+                        continue;
+                    }
+                    if (cost(tour[k], first) + cost(last, tour[k + 1]) - cost(tour[k], tour[k + 1]) < removed) {
+                        std::vector<int> run(tour.begin() + i, tour.begin() + i + length);
+                        tour.erase(tour.begin() + i, tour.begin() + i + length);
+                        int position = k < i ? k + 1 : k + 1 - length;
+                        tour.insert(tour.begin() + position, run.begin(), run.end());
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    };
+    auto twoOpt = [&]() {
+        forward[0] = backward[0] = backward[1] = 0;
+        for (int k = 0; k <= m; k++) {
+            forward[k + 1] = forward[k] + cost(tour[k], tour[k + 1]);
+            if (k >= 1) {
+                backward[k + 1] = backward[k] + (k + 1 <= m ? cost(tour[k + 1], tour[k]) : 0);
+            }
+        }
+        for (int i = 1; i < m; i++) {
+            for (int j = i + 1; j <= m; j++) {
+                long long current = cost(tour[i - 1], tour[i]) + forward[j] - forward[i] + cost(tour[j], tour[j + 1]);
+                long long reversed = cost(tour[i - 1], tour[j]) + backward[j] - backward[i] + cost(tour[i], tour[j + 1]);
+                if (reversed < current) {
+                    std::reverse(tour.begin() + i, tour.begin() + j + 1);
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+    while (orOpt() || twoOpt()) {
+    }
+    order.assign(tour.begin() + 1, tour.end() - 1);
+}
+
+/**
+ * @brief Finds the fastest driving route from source to dest that stops at every waypoint, in the given order or in the
+ * order that makes it fastest, respecting the nodes and edges to avoid.
+ *
+ * In the given order, each leg is a search from one stop that ends at the next. To optimize the order, a table with the
+ * time between every two stops is first filled with one search from source and from each waypoint to all the other stops,
+ * the order is chosen over the table by orderWaypoints, and the legs are then searched again to read their paths.
+ * Time complexity is O(M·log(V)(E+V)) for the searches, where M is the number of waypoints, plus the cost of orderWaypoints.
+ *
+ * @tparam T
+ * @param g graph where the route is calculated
+ * @param ctx search state of the calling thread
+ * @param source slot where the route starts
+ * @param dest slot where the route ends
+ * @param waypoints slots of the stops, at most maxWaypoints
+ * @param optimizeOrder whether the stops may be visited in any order, instead of the given one
+ * @param avoid_nodes nodes that the route can't go through
+ * @param avoid_edges edges that the route can't go through
+ * @param order used to return the indices in waypoints of the stops, in visiting order
+ * @param path used to return the route as a list of node ids
+ * @return int driving time of the route, or -1 if a slot is invalid or some leg has no path
+ */
+template <class T>
+int WaypointRoutePlanning(const CsrGraph<T>& g, SearchContext& ctx, int source, int dest, const std::vector<int>& waypoints, bool optimizeOrder, const std::unordered_set<T>& avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash>& avoid_edges, std::vector<int>& order, std::list<T>& path) {
+    order = {};
+    path = {};
+    int m = waypoints.size();
+    if (source == -1 || dest == -1 || m > maxWaypoints || std::find(waypoints.begin(), waypoints.end(), -1) != waypoints.end()) {
+        return -1;
+    }
+    ctx.getRestrictions().set(g, avoid_nodes, avoid_edges);
+    std::vector<int> times;
+
+    if (optimizeOrder && m > 1) {
+        // table[a * (m + 1) + b] is the time from source (a = 0) or waypoint a - 1 to waypoint b, or to dest (b = m)
+        std::vector<int> targets(waypoints);
+        targets.push_back(dest);
+        std::vector<long long> table;
+        const long long unreachable = std::numeric_limits<int>::max();
+        for (int a = 0; a <= m; a++) {
+            drivingOneToMany(g, ctx, a == 0 ? source : waypoints[a - 1], targets, times);
+            for (int time : times) {
+                table.push_back(time == -1 ? unreachable : time);
+            }
+        }
+        auto cost = [&](int a, int b) {
+            return table[(a == m ? 0 : a + 1) * (m + 1) + (b == m + 1 ? m : b)];
+        };
+        orderWaypoints(m, cost, order);
+    } else {
+        for (int i = 0; i < m; i++) {
+            order.push_back(i);
+        }
+    }
+
+    int total = 0;
+    int from = source;
+    for (int i = 0; i <= m; i++) {
+        int to = i < m ? waypoints[order[i]] : dest;
+        drivingOneToMany(g, ctx, from, {to}, times);
+        if (times[0] == -1) {
+            order = {};
+            path = {};
+            return -1;
+        }
+        std::list<T> leg;
+        getDrivingPath(g, ctx.getForward(), to, leg);
+        if (!path.empty()) {
+            leg.pop_front();
+        }
+        path.splice(path.end(), leg);
+        total += times[0];
+        from = to;
+    }
+    return total;
+}
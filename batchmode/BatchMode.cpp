@@ -6,15 +6,29 @@
 #include <vector>
 #include <string>
 #include <unordered_set>
-#include <regex>
+#include <cctype>
 #include "../utils/Graph.h"
+#include "../utils/CsrGraph.hpp"
+#include "../utils/SearchContext.hpp"
 #include "../utils/RestrictedDijkstra.hpp"
 #include "../utils/GetDrivingPath.hpp"
 #include "../algorithms/IndependentRoutePlanning.cpp"
+#include "../utils/ContractionHierarchy.hpp"
+#include "../utils/WalkingIndex.hpp"
 #include "../algorithms/RestrictedRoutePlanning.cpp"
+#include "../algorithms/KShortestRoutePlanning.cpp"
+#include "../algorithms/ViaNodeRoutePlanning.cpp"
+#include "../algorithms/WaypointRoutePlanning.cpp"
 #include "../algorithms/EnvironmentallyFriendly.cpp"
 #include "../algorithms/AlternativeRoutes.cpp"
 #include "../utils/GraphInitialization.cpp"
+#include "../utils/ThreadPool.h"
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <condition_variable>
+#include <mutex>
 
 using namespace std;
 
@@ -106,163 +120,620 @@ void outputDrivingWalkingPath(list<int>& path, int parkingNodeId, ostream& outpu
 }
 
 /**
- * @brief Processes a batch mode operation for route planning.
- * 
- * Reads input from "batchmode/input.txt", processes the data, and writes the output
- * to "batchmode/output.txt". Supports different routing modes and constraints.
- * 
- * @param graph The graph representing the road network.
+ * @brief One query record of a batch input, as read by BatchReader.
  */
-void processBatchMode(Graph<int>& graph) {
-    // INPUT //
-    ifstream inputFile("batchmode/input.txt");
-    ofstream outputFile("batchmode/output.txt");
-
-    if (!inputFile) {
-        cerr << "Error: Could not open input file.\n";
-        return;
-    }
-
+struct BatchQuery {
     string mode;
     int sourceId = -1, destinationId = -1;
     unordered_set<int> avoidNodes = {};
     unordered_set<pair<int, int>, pairHash> avoidEdges = {};
     int includeNode = -1;
     int maxWalkTime = -1;
+    int routes = -1;    // number of driving routes wanted, -1 for the best and independent alternative
+    int alternatives = -1;  // number of via-node alternatives wanted, -1 for the independent alternative
+    vector<int> waypointIds = {};   // stops of a waypoint route, empty for a route without them
+    bool optimizeWaypoints = false; // whether the stops may be visited in any order
+    vector<int> sourceIds = {}, destinationIds = {};    // driving-matrix queries
+    vector<pair<int, int>> pathPairs = {};              // driving-matrix pairs whose path is also wanted
+    string error;       // first parse error of the record, answered instead of the query
+};
 
-    string line;
-    while (getline(inputFile, line)) {
-        stringstream ss(line);
-        string key, value;
-        getline(ss, key, ':');
-        getline(ss, value);
-        if (key == "Mode") {
-            if (value != "driving" && value != "driving-walking") {
-                outputFile << "Error: Invalid mode. " << value << "\n";
-                outputFile.close();
-                return;
-            }
-            mode = value;
-        } else if (key == "Source") {
-            try {
-                sourceId = stoi(value);
-            } catch (invalid_argument& e) {
-                outputFile << "Error: Invalid source. " << value << "\n";
-                outputFile.close();
-                return;
-            }
-        } else if (key == "Destination") {
+/**
+ * @brief Appends every "(from,to)" pair found in value to pairs, skipping anything else.
+ * Runs in O(L) where L is the length of value.
+ *
+ * @param invalid used to return the pair that doesn't fit in an int, as "from,to"
+ * @return true on success, false if a node id does not fit in an int
+ */
+bool parseNodePairs(const string& value, vector<pair<int, int>>& pairs, string& invalid) {
+    size_t i = 0;
+    while ((i = value.find('(', i)) != string::npos) {
+        size_t a = i + 1, b = a;
+        while (b < value.size() && isdigit((unsigned char) value[b])) b++;
+        size_t c = b + 1, d = c;
+        while (d < value.size() && isdigit((unsigned char) value[d])) d++;
+        if (b == a || b >= value.size() || value[b] != ',' || d == c || d >= value.size() || value[d] != ')') {
+            i++;
+            continue;
+        }
+        try {
+            pairs.push_back({stoi(value.substr(a, b - a)), stoi(value.substr(c, d - c))});
+        } catch (exception& e) {
+            invalid = value.substr(a, b - a) + "," + value.substr(c, d - c);
+            return false;
+        }
+        i = d + 1;
+    }
+    return true;
+}
+
+/**
+ * @brief Appends every id of a comma-separated list to ids.
+ *
+ * @param invalid used to return the item that isn't an id
+ * @return true on success, false if an item isn't an id
+ */
+bool parseIdList(const string& value, vector<int>& ids, string& invalid) {
+    stringstream idsStream(value);
+    string id;
+    while (getline(idsStream, id, ',')) {
+        try {
+            ids.push_back(stoi(id));
+        } catch (exception& e) {
+            invalid = id;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Applies one "Key:Value" line to a query record. Unknown keys are ignored.
+ *
+ * @return true on success, false if the value is invalid (query.error is then set)
+ */
+bool parseBatchLine(BatchQuery& query, const string& key, const string& value) {
+    if (key == "Mode") {
+        if (value != "driving" && value != "driving-walking" && value != "driving-matrix") {
+            query.error = "Error: Invalid mode. " + value;
+            return false;
+        }
+        query.mode = value;
+    } else if (key == "Source") {
+        try {
+            query.sourceId = stoi(value);
+        } catch (exception& e) {
+            query.error = "Error: Invalid source. " + value;
+            return false;
+        }
+    } else if (key == "Destination") {
+        try {
+            query.destinationId = stoi(value);
+        } catch (exception& e) {
+            query.error = "Error: Invalid destination. " + value;
+            return false;
+        }
+    } else if (key == "AvoidNodes") {
+        stringstream nodesStream(value);
+        string node;
+        while (getline(nodesStream, node, ',')) {
             try {
-                destinationId = stoi(value);
-            } catch (invalid_argument& e) {
-                outputFile << "Error: Invalid destination. " << value << "\n";
-                outputFile.close();
-                return;
+                query.avoidNodes.insert(stoi(node));
+            } catch (exception& e) {
+                query.error = "Error: Invalid node to avoid. " + node;
+                return false;
             }
-        } else if (key == "AvoidNodes") {
-            stringstream nodesStream(value);
-            string node;
-            while (getline(nodesStream, node, ',')) {
-                try {
-                    avoidNodes.insert(stoi(node));
-                } catch (invalid_argument& e) {
-                    outputFile << "Error: Invalid node to avoid. " << node << "\n";
-                    outputFile.close();
-                    return;
-                }
-            }
-        } else if (key == "AvoidSegments") {
-            regex segmentRegex(R"(\((\d+),(\d+)\))");
-            smatch match;
-            string::const_iterator searchStart(value.cbegin());
-            while (regex_search(searchStart, value.cend(), match, segmentRegex)) {
-                try {
-                    int from = stoi(match[1]);
-                    int to = stoi(match[2]);
-                    avoidEdges.insert({from, to});
-                    searchStart = match.suffix().first;
-                } catch (invalid_argument& e) {
-                    outputFile << "Error: Invalid edge to avoid. " << match[1] << "," << match[2] << "\n";
-                    outputFile.close();
-                    return;
-                }
+        }
+    } else if (key == "AvoidSegments") {
+        vector<pair<int, int>> segments;
+        string invalid;
+        if (!parseNodePairs(value, segments, invalid)) {
+            query.error = "Error: Invalid edge to avoid. " + invalid;
+            return false;
+        }
+        query.avoidEdges.insert(segments.begin(), segments.end());
+    } else if (key == "Sources") {
+        string invalid;
+        if (!parseIdList(value, query.sourceIds, invalid)) {
+            query.error = "Error: Invalid source. " + invalid;
+            return false;
+        }
+    } else if (key == "Destinations") {
+        string invalid;
+        if (!parseIdList(value, query.destinationIds, invalid)) {
+            query.error = "Error: Invalid destination. " + invalid;
+            return false;
+        }
+    } else if (key == "Paths") {
+        string invalid;
+        if (!parseNodePairs(value, query.pathPairs, invalid)) {
+            query.error = "Error: Invalid path. " + invalid;
+            return false;
+        }
+    } else if (key == "IncludeNode") {
+        if (value == "") {
+            return true;
+        }
+        try {
+            query.includeNode = stoi(value);
+        } catch (exception& e) {
+            query.error = "Error: Invalid node to include. " + value;
+            return false;
+        }
+    } else if (key == "Routes") {
+        try {
+            query.routes = stoi(value);
+        } catch (exception& e) {
+            query.routes = 0;
+        }
+        if (query.routes < 1 || query.routes > maxShortestRoutes) {
+            query.error = "Error: Invalid number of routes. " + value;
+            return false;
+        }
+    } else if (key == "Alternatives") {
+        try {
+            query.alternatives = stoi(value);
+        } catch (exception& e) {
+            query.alternatives = 0;
+        }
+        if (query.alternatives < 1 || query.alternatives > maxViaAlternatives) {
+            query.error = "Error: Invalid number of alternatives. " + value;
+            return false;
+        }
+    } else if (key == "Waypoints") {
+        string invalid;
+        if (!parseIdList(value, query.waypointIds, invalid)) {
+            query.error = "Error: Invalid waypoint. " + invalid;
+            return false;
+        }
+        if ((int) query.waypointIds.size() > maxWaypoints) {
+            query.error = "Error: Invalid number of waypoints. " + to_string(query.waypointIds.size());
+            return false;
+        }
+    } else if (key == "WaypointOrder") {
+        if (value != "fixed" && value != "optimized") {
+            query.error = "Error: Invalid waypoint order. " + value;
+            return false;
+        }
+        query.optimizeWaypoints = value == "optimized";
+    } else if (key == "MaxWalkTime") {
+        if (value == "") {
+            query.maxWalkTime = std::numeric_limits<int>::max();
+            return true;
+        }
+        try {
+            query.maxWalkTime = stoi(value);
+        } catch (exception& e) {
+            query.error = "Error: Invalid max walk time. " + value;
+            return false;
+        }
+    }
+    return true;
+}
+
+/************************* BatchReader  **************************/
+
+/**
+ * @brief Reads query records one at a time from a stream, so the input is never held in memory as a whole.
+ *
+ * A record is a group of "Key:Value" lines (Mode, Source, Destination, AvoidNodes, AvoidSegments, IncludeNode,
+ * MaxWalkTime, Routes, Alternatives, Waypoints, WaypointOrder, and Sources, Destinations and Paths for driving-matrix records). It ends at a blank line, or where one
+ * of its keys appears again, which starts the next record. A file with a single record reads as before.
+ */
+class BatchReader {
+public:
+    explicit BatchReader(istream& in): in(in) {}
+
+    /**
+     * @brief Reads the next record into query. Runs in O(L) where L is the length of the record.
+     *
+     * @return true if a record was read, false at the end of the input
+     */
+    bool next(BatchQuery& query);
+
+    /**
+     * @brief Tells whether reading more would have to wait for the stream (nothing is buffered), so pending output
+     * should be flushed first.
+     */
+    bool isDrained() const;
+
+private:
+    istream& in;
+    string pending;             // line that started the next record
+    bool hasPending = false;
+};
+
+inline bool BatchReader::next(BatchQuery& query) {
+    static const string keys[] = {"Mode", "Source", "Destination", "AvoidNodes", "AvoidSegments", "IncludeNode", "MaxWalkTime", "Sources", "Destinations", "Paths", "Routes", "Alternatives", "Waypoints", "WaypointOrder"};
+    query = BatchQuery();
+    unsigned seen = 0;
+    bool started = false;
+    string line;
+    while (hasPending || getline(in, line)) {
+        if (hasPending) {
+            line.swap(pending);
+            hasPending = false;
+        }
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            if (started) {
+                return true;
             }
-        } else if (key == "IncludeNode") {
-            if (value == "") {
+            continue;
+        }
+        size_t colon = line.find(':');
+        string key = line.substr(0, colon);
+        string value = colon == string::npos ? "" : line.substr(colon + 1);
+        for (unsigned k = 0; k < sizeof(keys) / sizeof(keys[0]); k++) {
+            if (key != keys[k]) {
                 continue;
             }
-            try {
-                includeNode = stoi(value);
-            } catch (invalid_argument& e) {
-                outputFile << "Error: Invalid node to include. " << value << "\n";
-                outputFile.close();
-                return;
+            if (seen & (1u << k)) {
+                pending.swap(line);
+                hasPending = true;
+                return true;
             }
-        } else if (key == "MaxWalkTime") {
-            if (value == "") {
-                maxWalkTime = std::numeric_limits<int>::max();
-                continue;
+            seen |= 1u << k;
+        }
+        started = true;
+        if (query.error.empty()) {
+            parseBatchLine(query, key, value);
+        }
+    }
+    return started;
+}
+
+inline bool BatchReader::isDrained() const {
+    return !hasPending && in.rdbuf()->in_avail() <= 0;
+}
+
+/************************* BatchWriter  **************************/
+
+/**
+ * @brief Collects the answers in a large buffer and writes it to the stream in blocks.
+ */
+class BatchWriter {
+public:
+    explicit BatchWriter(ostream& out): out(out) {}
+    ~BatchWriter() { flush(); }
+
+    void write(const string& text);
+    void flush();
+
+private:
+    ostream& out;
+    string buffer;
+    static const size_t capacity = 1 << 20;
+};
+
+inline void BatchWriter::write(const string& text) {
+    buffer += text;
+    if (buffer.size() >= capacity) {
+        flush();
+    }
+}
+
+inline void BatchWriter::flush() {
+    if (!buffer.empty()) {
+        out.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+    out.flush();
+}
+
+/************************* BatchHierarchy  **************************/
+
+/**
+ * @brief Priority queue of the driving-walking searches of batch mode: the binary heap, Dial's buckets or the radix heap.
+ */
+enum BatchQueue { HEAP_QUEUE, DIAL_QUEUE, RADIX_QUEUE };
+
+/**
+ * @brief Contraction hierarchy of the batch graph, built the first time a query needs it, so batches without
+ * driving-matrix queries don't pay for it. It also carries the walking index, the landmarks, the all-pairs tables and the
+ * multi-level overlay of the graph, if they were built, and the queue of the driving-walking searches.
+ * It can be shared by every worker.
+ */
+class BatchHierarchy {
+public:
+    explicit BatchHierarchy(const CsrGraph<int>& graph, const WalkingIndex<int>* walkingIndex = nullptr, const Landmarks<int>* landmarks = nullptr, BatchQueue queue = HEAP_QUEUE, const AllPairs<int>* allPairs = nullptr, const MultiLevelOverlay<int>* overlay = nullptr): graph(graph), walkingIndex(walkingIndex), landmarks(landmarks), queue(queue), allPairs(allPairs), overlay(overlay) {}
+
+    const ContractionHierarchy<int>& get();
+
+    /**
+     * @brief Walking index read by the driving-walking queries it covers, or nullptr.
+     */
+    const WalkingIndex<int>* getWalkingIndex() const;
+
+    /**
+     * @brief Landmarks directing the searches of restricted driving queries without an overlay, or nullptr.
+     */
+    const Landmarks<int>* getLandmarks() const;
+
+    /**
+     * @brief Queue of the driving-walking searches shared by the queries of a block.
+     */
+    BatchQueue getQueue() const;
+
+    /**
+     * @brief All-pairs tables read by the unrestricted driving and driving-walking queries, or nullptr.
+     */
+    const AllPairs<int>* getAllPairs() const;
+
+    /**
+     * @brief Overlay answering the restricted driving queries, or nullptr.
+     */
+    const MultiLevelOverlay<int>* getOverlay() const;
+
+private:
+    const CsrGraph<int>& graph;
+    const WalkingIndex<int>* walkingIndex;
+    const Landmarks<int>* landmarks;
+    BatchQueue queue;
+    const AllPairs<int>* allPairs;
+    const MultiLevelOverlay<int>* overlay;
+    once_flag built;
+    unique_ptr<ContractionHierarchy<int>> hierarchy;
+};
+
+inline const ContractionHierarchy<int>& BatchHierarchy::get() {
+    call_once(built, [this] { hierarchy.reset(new ContractionHierarchy<int>(graph)); });
+    return *hierarchy;
+}
+
+inline const WalkingIndex<int>* BatchHierarchy::getWalkingIndex() const {
+    return walkingIndex;
+}
+
+inline const Landmarks<int>* BatchHierarchy::getLandmarks() const {
+    return landmarks;
+}
+
+inline BatchQueue BatchHierarchy::getQueue() const {
+    return queue;
+}
+
+inline const AllPairs<int>* BatchHierarchy::getAllPairs() const {
+    return allPairs;
+}
+
+inline const MultiLevelOverlay<int>* BatchHierarchy::getOverlay() const {
+    return overlay;
+}
+
+/**
+ * @brief Answers a driving-matrix query: the driving times from every source to every destination, one row per source,
+ * followed by the path of each requested pair. Times come from a single many-to-many search over the contraction
+ * hierarchy; each path is found with one point-to-point query.
+ * Runs in O((S+T)·U·log U + S·T + P·Q), where U is the size of an upward search space and Q the cost of a query, for P paths.
+ *
+ * @param ch Contraction hierarchy of the graph.
+ * @param ctx Search state of the calling thread.
+ * @param query The query record.
+ * @param outputFile Stream where the answer is written.
+ */
+void answerMatrixQuery(const ContractionHierarchy<int>& ch, SearchContext& ctx, const BatchQuery& query, ostream& outputFile) {
+    const CsrGraph<int>& graph = ch.getGraph();
+    vector<int> sources, destinations;
+    for (int id : query.sourceIds) {
+        sources.push_back(graph.findSlotById(id));
+        if (sources.back() == -1) {
+            outputFile << "Error: Invalid source. " << id << "\n";
+            return;
+        }
+    }
+    for (int id : query.destinationIds) {
+        destinations.push_back(graph.findSlotById(id));
+        if (destinations.back() == -1) {
+            outputFile << "Error: Invalid destination. " << id << "\n";
+            return;
+        }
+    }
+    for (const auto& pair : query.pathPairs) {
+        if (graph.findSlotById(pair.first) == -1 || graph.findSlotById(pair.second) == -1) {
+            outputFile << "Error: Invalid path. " << pair.first << "," << pair.second << "\n";
+            return;
+        }
+    }
+    vector<int> table;
+    ch.manyToMany(ctx, sources, destinations, table);
+
+    outputFile << "Sources:";
+    for (size_t i = 0; i < query.sourceIds.size(); i++) {
+        outputFile << (i > 0 ? "," : "") << query.sourceIds[i];
+    }
+    outputFile << "\nDestinations:";
+    for (size_t j = 0; j < query.destinationIds.size(); j++) {
+        outputFile << (j > 0 ? "," : "") << query.destinationIds[j];
+    }
+    outputFile << "\nDrivingTimes:\n";
+    for (size_t i = 0; i < sources.size(); i++) {
+        outputFile << query.sourceIds[i] << ":";
+        for (size_t j = 0; j < destinations.size(); j++) {
+            int time = table[i * destinations.size() + j];
+            outputFile << (j > 0 ? "," : "");
+            if (time == -1) {
+                outputFile << "none";
+            } else {
+                outputFile << time;
             }
-            try {
-                maxWalkTime = stoi(value);
-            } catch (invalid_argument& e) {
-                outputFile << "Error: Invalid max walk time. " << value << "\n";
-                outputFile.close();
-                return;
+        }
+        outputFile << "\n";
+    }
+    for (const auto& pair : query.pathPairs) {
+        int source = graph.findSlotById(pair.first), destination = graph.findSlotById(pair.second);
+        int meetingNode;
+        int time = ch.query(ctx, source, destination, meetingNode);
+        list<int> path = {};
+        if (meetingNode != -1) {
+            vector<int> edges;
+            ch.unpackPath(ctx, meetingNode, edges);
+            path.push_back(pair.first);
+            for (int e : edges) {
+                path.push_back(graph.getId(graph.getEdgeDest(e)));
             }
         }
+        outputFile << "Path(" << pair.first << "," << pair.second << "):";
+        if (source == destination) {
+            outputFile << pair.first << "(0)\n";
+        } else {
+            outputPathAndCost(path, time, outputFile);
+        }
     }
+}
 
-    inputFile.close();
+/**
+ * @brief Driving-walking route found ahead of time by planBatchQueries.
+ */
+struct DrivingWalkingAnswer {
+    bool found = false;     // whether a route was found; if not, the query is answered on its own
+    list<int> path = {};
+    int parkingNodeId = -1;
+    int walkingTime = 0, drivingTime = 0;
+};
 
+/**
+ * @brief Answers one batch query, writing the same lines the single-query batch mode always wrote.
+ *
+ * @param graph The graph representing the road network.
+ * @param hierarchy Contraction hierarchy of graph, used by driving-matrix queries.
+ * @param ctx Search state of the calling thread.
+ * @param query The query record.
+ * @param outputFile Stream where the answer is written.
+ * @param planned Route found by planBatchQueries for a driving-walking query, or nullptr.
+ */
+void answerBatchQuery(const CsrGraph<int>& graph, BatchHierarchy& hierarchy, SearchContext& ctx, const BatchQuery& query, ostream& outputFile, const DrivingWalkingAnswer* planned = nullptr) {
+    if (!query.error.empty()) {
+        outputFile << query.error << "\n";
+        return;
+    }
+    if (query.mode == "driving-matrix") {
+        answerMatrixQuery(hierarchy.get(), ctx, query, outputFile);
+        return;
+    }
+    int source = graph.findSlotById(query.sourceId);
+    if (source == -1) {
+        outputFile << "Error: Invalid source. " << query.sourceId << "\n";
+        return;
+    }
+    int destination = graph.findSlotById(query.destinationId);
+    if (destination == -1) {
+        outputFile << "Error: Invalid destination. " << query.destinationId << "\n";
+        return;
+    }
 
-    // OUTPUT //
-    Vertex<int>* source = graph.findVertexById(sourceId);
-    if (source == nullptr) {
-        outputFile << "Error: Invalid source. " << sourceId << "\n";
-        outputFile.close();
+    if (query.mode == "driving" && query.routes != -1 && query.includeNode != -1) {
+        outputFile << "Error: IncludeNode can't be used with Routes.\n";
         return;
     }
-    Vertex<int>* destination = graph.findVertexById(destinationId);
-    if (destination == nullptr) {
-        outputFile << "Error: Invalid destination. " << destinationId << "\n";
-        outputFile.close();
+    if (query.mode == "driving" && query.alternatives != -1 && (query.includeNode != -1 || query.routes != -1)) {
+        outputFile << "Error: Alternatives can't be used with IncludeNode or Routes.\n";
         return;
     }
+    vector<int> waypoints;
+    if (query.mode == "driving" && !query.waypointIds.empty()) {
+        if (query.includeNode != -1 || query.routes != -1 || query.alternatives != -1) {
+            outputFile << "Error: Waypoints can't be used with IncludeNode, Routes or Alternatives.\n";
+            return;
+        }
+        for (int id : query.waypointIds) {
+            waypoints.push_back(graph.findSlotById(id));
+            if (waypoints.back() == -1) {
+                outputFile << "Error: Invalid waypoint. " << id << "\n";
+                return;
+            }
+        }
+    }
+
+    outputSourceDest(query.sourceId, query.destinationId, outputFile);
+
+    // WAYPOINT ROUTE PLANNING
+    if (query.mode == "driving" && !waypoints.empty()) {
+        vector<int> order;
+        list<int> path = {};
+        int time = WaypointRoutePlanning(graph, ctx, source, destination, waypoints, query.optimizeWaypoints, query.avoidNodes, query.avoidEdges, order, path);
+        outputFile << "WaypointOrder:";
+        for (size_t i = 0; i < order.size(); i++) {
+            outputFile << (i > 0 ? "," : "") << query.waypointIds[order[i]];
+        }
+        outputFile << (order.empty() ? "none\n" : "\n");
+        outputFile << "WaypointDrivingRoute:";
+        outputPathAndCost(path, time, outputFile);
 
-    outputSourceDest(sourceId, destinationId, outputFile);
+    // K SHORTEST ROUTE PLANNING
+    } else if (query.mode == "driving" && query.routes != -1) {
+        vector<list<int>> paths;
+        vector<int> times;
+        int found = KShortestRoutePlanning(graph, ctx, source, destination, query.routes, query.avoidNodes, query.avoidEdges, paths, times);
+        if (found <= 0) {
+            outputFile << "DrivingRoute1:none\n";
+        }
+        for (int i = 0; i < found; i++) {
+            outputFile << "DrivingRoute" << i + 1 << ":";
+            outputPathAndCost(paths[i], times[i], outputFile);
+        }
+
+    // VIA-NODE ALTERNATIVE ROUTES
+    } else if (query.mode == "driving" && query.alternatives != -1) {
+        vector<list<int>> paths;
+        vector<int> times;
+        int found = ViaNodeRoutePlanning(graph, ctx, source, destination, query.alternatives, query.avoidNodes, query.avoidEdges, paths, times);
+        list<int> none = {};
+        outputFile << "BestDrivingRoute:";
+        outputPathAndCost(found > 0 ? paths[0] : none, found > 0 ? times[0] : -1, outputFile);
+        if (found <= 1) {
+            outputFile << "AlternativeDrivingRoute1:none\n";
+        }
+        for (int i = 1; i < found; i++) {
+            outputFile << "AlternativeDrivingRoute" << i << ":";
+            outputPathAndCost(paths[i], times[i], outputFile);
+        }
 
-    if (mode == "driving" && avoidNodes.empty() && avoidEdges.empty() && includeNode == -1) {
+    } else if (query.mode == "driving" && query.avoidNodes.empty() && query.avoidEdges.empty() && query.includeNode == -1) {
 
         list<int> bestPath = {}, altPath = {};
         int bestTime = -1, altTime = -1;
 
-        IndependentRoutePlanning(graph, source, destination, bestPath, bestTime, altPath, altTime);
+        if (hierarchy.getAllPairs() != nullptr) {
+            IndependentRoutePlanning(*hierarchy.getAllPairs(), ctx, source, destination, bestPath, bestTime, altPath, altTime);
+        } else {
+            IndependentRoutePlanning(graph, ctx, source, destination, bestPath, bestTime, altPath, altTime);
+        }
         outputFile << "BestDrivingRoute:";
         outputPathAndCost(bestPath, bestTime, outputFile);
         outputFile << "AlternativeDrivingRoute:";
         outputPathAndCost(altPath, altTime, outputFile);
 
     // RESTRICTED ROUTE PLANNING
-    } else if (mode == "driving") {
+    } else if (query.mode == "driving") {
         list<int> bestPath = {};
-        int bestTime = -1;
-        int time = RestrictedRoutePlanning(graph, source, destination, avoidNodes, avoidEdges, graph.findVertexById(includeNode), bestPath);
+        int time;
+        if (hierarchy.getOverlay() != nullptr) {
+            time = RestrictedRoutePlanning(*hierarchy.getOverlay(), ctx, source, destination, query.avoidNodes, query.avoidEdges, graph.findSlotById(query.includeNode), bestPath);
+        } else {
+            time = RestrictedRoutePlanning(graph, ctx, source, destination, query.avoidNodes, query.avoidEdges, graph.findSlotById(query.includeNode), bestPath, hierarchy.getLandmarks());
+        }
         outputFile << "RestrictedDrivingRoute:";
         outputPathAndCost(bestPath, time, outputFile);
 
     //ENVIRONMENTALLY-FRIENDLY ROUTE PLANNING
-    } else if (mode == "driving-walking" && maxWalkTime != -1) {
+    } else if (query.mode == "driving-walking" && query.maxWalkTime != -1 && planned != nullptr && planned->found) {
+        list<int> path = planned->path;
+        int walkingTime = planned->walkingTime, drivingTime = planned->drivingTime;
+        outputDrivingWalkingPath(path, planned->parkingNodeId, outputFile, drivingTime, walkingTime, "");
+    } else if (query.mode == "driving-walking" && query.maxWalkTime != -1) {
         list<int> path = {};
         int parkingNodeId;
         int walkingTime, drivingTime;
-        int err = calculateEnvironmentallyFriendlyPath(graph, source, destination, maxWalkTime, avoidNodes, avoidEdges, path, parkingNodeId, walkingTime, drivingTime);
+        int err = calculateEnvironmentallyFriendlyPath<int>(graph, ctx, source, destination, query.maxWalkTime, query.avoidNodes, query.avoidEdges, path, parkingNodeId, walkingTime, drivingTime, hierarchy.getWalkingIndex(), nullptr, hierarchy.getAllPairs());
         if (err != 0) {
             outputFile << "DrivingRoute:\nParkingNode:\nWalkingRoute:\nTotalTime:\nMessage:";
             int parkingNodeId1, parkingNodeId2;
             int walkingTime1 = std::numeric_limits<int>::max(), walkingTime2= std::numeric_limits<int>::max(), drivingTime1= std::numeric_limits<int>::max(), drivingTime2= std::numeric_limits<int>::max();
             std::list<int> path1 = {}, path2 = {};
-            std::string message = AlternativeRoutes(graph, source, destination, maxWalkTime, avoidNodes, avoidEdges, path1, parkingNodeId1, walkingTime1, drivingTime1, path2, parkingNodeId2, walkingTime2, drivingTime2);
+            std::string message = AlternativeRoutes(graph, ctx, source, destination, query.maxWalkTime, query.avoidNodes, query.avoidEdges, path1, parkingNodeId1, walkingTime1, drivingTime1, path2, parkingNodeId2, walkingTime2, drivingTime2);
             outputFile << message << "\n";
             outputDrivingWalkingPath(path1, parkingNodeId1, outputFile, drivingTime1, walkingTime1, "1");
             outputDrivingWalkingPath(path2, parkingNodeId2, outputFile, drivingTime2, walkingTime2, "2");
@@ -270,8 +741,524 @@ void processBatchMode(Graph<int>& graph) {
             outputDrivingWalkingPath(path, parkingNodeId, outputFile, drivingTime, walkingTime, "");
         }
     }
+}
 
-    outputFile.close();
-    cout << "\nBatch mode processing completed!\nPlease check output.txt \n";
+/**
+ * @brief Canonical form of the restrictions of a query, equal for two queries exactly when they avoid the same nodes and segments.
+ */
+string batchRestrictionKey(const BatchQuery& query) {
+    vector<int> nodes(query.avoidNodes.begin(), query.avoidNodes.end());
+    vector<pair<int, int>> edges(query.avoidEdges.begin(), query.avoidEdges.end());
+    sort(nodes.begin(), nodes.end());
+    sort(edges.begin(), edges.end());
+    ostringstream key;
+    for (int node : nodes) {
+        key << node << ",";
+    }
+    key << "|";
+    for (const auto& edge : edges) {
+        key << edge.first << "," << edge.second << ",";
+    }
+    return key.str();
 }
 
+/**
+ * @brief Whether a query is a valid driving-walking query, the kind planBatchQueries coalesces.
+ */
+bool isDrivingWalkingQuery(const CsrGraph<int>& graph, const BatchQuery& query) {
+    return query.error.empty() && query.mode == "driving-walking" && query.maxWalkTime != -1 && graph.findSlotById(query.sourceId) != -1 && graph.findSlotById(query.destinationId) != -1;
+}
+
+/**
+ * @brief Finds ahead of time the routes of the driving-walking queries of a block, sharing searches between them.
+ *
+ * Queries with the same destination, maximum walking time and restrictions share one reverse walking search, whose
+ * tree is kept for the candidates' walking paths; the walking index replaces that search when it covers the group.
+ * Queries with the same source and restrictions share one driving
+ * search that settles the whole graph, from which each query picks its parking node in the order drivingDijkstra would
+ * have settled it, so every route is exactly the one calculateEnvironmentallyFriendlyPath finds without landmarks, whatever
+ * else is in the block. Landmarks aren't used here: drivingAStar may break ties between equal routes differently, and a
+ * query's route would then depend on whether its source is shared by another query of its block. Queries without a
+ * route are left for answerBatchQuery, which also finds their alternatives, and so are queries without a walking limit,
+ * which calculateEnvironmentallyFriendlyPath answers with its layered search, and, with all-pairs tables, queries without
+ * restrictions, which it reads from the tables.
+ * Total time complexity is O((S+D)(V+E)logV), where S and D are the numbers of distinct sources and destinations.
+ *
+ * @tparam PQ Queue of the walking and driving searches. Between routes of the same times, the one picked follows its
+ * order, so a queue other than SlotPriorityQueue may give another route of the same times.
+ * @param graph The graph representing the road network.
+ * @param ctx Search state of the calling thread.
+ * @param queries The query records of the block.
+ * @param answers Used to return the route of each query, in the same order.
+ * @param walkingIndex Parking candidates of every vertex, or nullptr.
+ * @param allPairs All-pairs tables of graph, or nullptr.
+ */
+template <class PQ = SlotPriorityQueue>
+void planBatchQueries(const CsrGraph<int>& graph, SearchContext& ctx, const vector<BatchQuery>& queries, vector<DrivingWalkingAnswer>& answers, const WalkingIndex<int>* walkingIndex = nullptr, const AllPairs<int>* allPairs = nullptr) {
+    struct WalkingSearch {
+        int destination;
+        bool indexed;                           // whether the walking paths are read from the walking index
+        unordered_map<int, int> reacheable;     // parking candidates and their walking time to the destination
+        unordered_map<int, int> tree;           // walking edge taken from each vertex on a candidate's path, -1 at the destination
+    };
+    answers.assign(queries.size(), DrivingWalkingAnswer());
+    vector<string> restrictions(queries.size());
+    unordered_map<string, vector<int>> byDestination, bySource;
+    for (size_t i = 0; i < queries.size(); i++) {
+        // Without a walking limit the layered search of calculateEnvironmentallyFriendlyPath beats a shared walking search
+        if (!isDrivingWalkingQuery(graph, queries[i]) || queries[i].maxWalkTime == std::numeric_limits<int>::max()) {
+            continue;
+        }
+        if (allPairs != nullptr && queries[i].avoidNodes.empty() && queries[i].avoidEdges.empty()) {
+            continue;
+        }
+        restrictions[i] = batchRestrictionKey(queries[i]);
+        byDestination[to_string(queries[i].destinationId) + " " + to_string(queries[i].maxWalkTime) + " " + restrictions[i]].push_back(i);
+        bySource[to_string(queries[i].sourceId) + " " + restrictions[i]].push_back(i);
+    }
+
+    vector<WalkingSearch> walks;
+    vector<int> walkOf(queries.size(), -1);
+    for (const auto& group : byDestination) {
+        const BatchQuery& first = queries[group.second[0]];
+        WalkingSearch walk;
+        walk.destination = graph.findSlotById(first.destinationId);
+        walk.indexed = walkingIndex != nullptr && walkingIndex->covers(walk.destination, first.maxWalkTime, first.avoidNodes, first.avoidEdges);
+        if (walk.indexed) {
+            walkingIndex->getReacheableParking(walk.destination, -1, first.maxWalkTime, walk.reacheable);
+        } else {
+            walkingReverseDijsktra<int, PQ>(graph, ctx, walk.destination, -1, first.maxWalkTime, first.avoidNodes, first.avoidEdges, walk.reacheable);
+            const SearchLabels& labels = ctx.getBackward();
+            for (const auto& candidate : walk.reacheable) {
+                int v = candidate.first;
+                while (walk.tree.find(v) == walk.tree.end()) {
+                    int e = labels.getPath(v);
+                    walk.tree[v] = e;
+                    if (e == -1) {
+                        break;
+                    }
+                    v = graph.getEdgeDest(e);
+                }
+            }
+        }
+        for (int i : group.second) {
+            walkOf[i] = walks.size();
+        }
+        walks.push_back(std::move(walk));
+    }
+
+    vector<int> settleRank;
+    for (const auto& group : bySource) {
+        int source = graph.findSlotById(queries[group.second[0]].sourceId);
+        if (group.second.size() > 1) {
+            drivingDijkstraAll<int, PQ>(graph, ctx, source, queries[group.second[0]].avoidNodes, queries[group.second[0]].avoidEdges, settleRank);
+        }
+        for (int i : group.second) {
+            const BatchQuery& query = queries[i];
+            const WalkingSearch& walk = walks[walkOf[i]];
+            DrivingWalkingAnswer& answer = answers[i];
+            if (walk.reacheable.size() - walk.reacheable.count(source) == 0) {
+                continue;
+            }
+            int parkingNode;
+            if (group.second.size() > 1) {
+                parkingNode = selectParkingNode(ctx, source, settleRank, walk.reacheable, answer.walkingTime, answer.drivingTime);
+            } else {
+                unordered_map<int, int> reacheable = walk.reacheable;
+                reacheable.erase(source);
+                parkingNode = drivingDijkstra<int, PQ>(graph, ctx, source, query.avoidNodes, query.avoidEdges, reacheable, answer.walkingTime, answer.drivingTime);
+            }
+            if (parkingNode == -1) {
+                continue;
+            }
+            answer.found = true;
+            answer.parkingNodeId = graph.getId(parkingNode);
+            if (walk.indexed) {
+                walkingIndex->getWalkingPath(walk.destination, parkingNode, answer.path);
+            } else {
+                for (int e = walk.tree.at(parkingNode); e != -1; e = walk.tree.at(graph.getEdgeDest(e))) {
+                    answer.path.push_back(graph.getId(graph.getEdgeDest(e)));
+                }
+            }
+            getDrivingPath(graph, ctx.getForward(), parkingNode, answer.path);
+        }
+    }
+}
+
+/**
+ * @brief Records answered together, so planBatchQueries can share searches between them.
+ */
+struct BatchBlock {
+    vector<BatchQuery> queries;
+    vector<int> seqs;                                   // position of each record in the stream
+    vector<chrono::steady_clock::time_point> received;  // when each record was read
+};
+
+/**
+ * @brief Answers the records of a block. Each answer is preceded by a blank line, separating it from the previous answer,
+ * unless it's the first of the stream, and, if reportLatency is set, followed by a "Latency:" line with the microseconds
+ * elapsed since its record was read.
+ *
+ * @param graph The graph representing the road network.
+ * @param hierarchy Contraction hierarchy of graph, used by driving-matrix queries.
+ * @param ctx Search state of the calling thread.
+ * @param block The records.
+ * @param reportLatency Whether each answer ends with the time taken to answer it.
+ * @param answers Used to return the answer of each record, in the same order.
+ */
+void answerBatchBlock(const CsrGraph<int>& graph, BatchHierarchy& hierarchy, SearchContext& ctx, const BatchBlock& block, bool reportLatency, vector<string>& answers) {
+    vector<DrivingWalkingAnswer> planned;
+    if (hierarchy.getQueue() == DIAL_QUEUE) {
+        planBatchQueries<DialQueue>(graph, ctx, block.queries, planned, hierarchy.getWalkingIndex(), hierarchy.getAllPairs());
+    } else if (hierarchy.getQueue() == RADIX_QUEUE) {
+        planBatchQueries<RadixHeap>(graph, ctx, block.queries, planned, hierarchy.getWalkingIndex(), hierarchy.getAllPairs());
+    } else {
+        planBatchQueries(graph, ctx, block.queries, planned, hierarchy.getWalkingIndex(), hierarchy.getAllPairs());
+    }
+    answers.resize(block.queries.size());
+    for (size_t i = 0; i < block.queries.size(); i++) {
+        ostringstream text;
+        if (block.seqs[i] > 0) {
+            text << "\n";
+        }
+        answerBatchQuery(graph, hierarchy, ctx, block.queries[i], text, &planned[i]);
+        if (reportLatency) {
+            text << "Latency:" << chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - block.received[i]).count() << "us\n";
+        }
+        answers[i] = text.str();
+    }
+}
+
+/**
+ * @brief Reads records into block until reading more would wait for the stream, or block holds capacity records.
+ *
+ * @param firstSeq Position in the stream of the first record read.
+ * @return true if the input has more records, false if it ended.
+ */
+bool readBatchBlock(BatchReader& reader, BatchBlock& block, int firstSeq, int capacity) {
+    block.queries.clear();
+    block.seqs.clear();
+    block.received.clear();
+    BatchQuery query;
+    do {
+        if (!reader.next(query)) {
+            return false;
+        }
+        block.queries.push_back(std::move(query));
+        block.seqs.push_back(firstSeq + block.queries.size() - 1);
+        block.received.push_back(chrono::steady_clock::now());
+    } while ((int) block.queries.size() < capacity && !reader.isDrained());
+    return true;
+}
+
+/**
+ * @brief Splits a block into parts that can be answered independently. Driving-walking queries that would share a search
+ * (see planBatchQueries) are kept in the same part, as long as it doesn't grow past maxSize records; every other record
+ * is a part of its own. Runs in O(N log N) where N is the number of records.
+ */
+void splitBatchBlock(const CsrGraph<int>& graph, const BatchBlock& block, int maxSize, vector<BatchBlock>& parts) {
+    int n = block.queries.size();
+    vector<int> representative(n);
+    for (int i = 0; i < n; i++) {
+        representative[i] = i;
+    }
+    function<int(int)> find = [&](int i) { return representative[i] == i ? i : representative[i] = find(representative[i]); };
+    unordered_map<string, int> firstWithKey;
+    for (int i = 0; i < n; i++) {
+        const BatchQuery& query = block.queries[i];
+        if (!isDrivingWalkingQuery(graph, query)) {
+            continue;
+        }
+        string restrictions = batchRestrictionKey(query);
+        for (const string& key : {"d " + to_string(query.destinationId) + " " + to_string(query.maxWalkTime) + " " + restrictions, "s " + to_string(query.sourceId) + " " + restrictions}) {
+            auto it = firstWithKey.insert({key, i}).first;
+            representative[find(i)] = find(it->second);
+        }
+    }
+    map<int, vector<int>> components;
+    for (int i = 0; i < n; i++) {
+        components[find(i)].push_back(i);
+    }
+    parts.clear();
+    for (const auto& component : components) {
+        for (size_t start = 0; start < component.second.size(); start += maxSize) {
+            BatchBlock part;
+            for (size_t k = start; k < component.second.size() && k < start + maxSize; k++) {
+                int i = component.second[k];
+                part.queries.push_back(block.queries[i]);
+                part.seqs.push_back(block.seqs[i]);
+                part.received.push_back(block.received[i]);
+            }
+            parts.push_back(std::move(part));
+        }
+    }
+}
+
+/**
+ * @brief Answers every query record of a stream, in order. Records are parsed in blocks of what the input already
+ * holds, up to 1024 records, and the driving-walking queries of a block share searches (see planBatchQueries). Each
+ * answer goes to a buffered writer as soon as it is ready; answers are separated by a blank line. The buffer is also
+ * flushed whenever the input has nothing more buffered, so a client feeding queries through a pipe gets each answer
+ * without waiting. Memory use is independent of the number of records.
+ *
+ * @param graph The graph representing the road network.
+ * @param in Stream with the query records.
+ * @param out Stream where the answers are written.
+ * @param reportLatency Whether each answer ends with the time taken to answer it.
+ * @param hierarchy Contraction hierarchy of graph shared with other streams, or nullptr to build one when needed.
+ * @return int Number of records answered.
+ */
+int processBatchStream(const CsrGraph<int>& graph, istream& in, ostream& out, bool reportLatency = false, BatchHierarchy* hierarchy = nullptr) {
+    BatchHierarchy ownHierarchy(graph);
+    if (hierarchy == nullptr) {
+        hierarchy = &ownHierarchy;
+    }
+    BatchReader reader(in);
+    BatchWriter writer(out);
+    SearchContext ctx;
+    BatchBlock block;
+    vector<string> answers;
+    int count = 0;
+    bool more = true;
+    while (more) {
+        if (reader.isDrained()) {
+            writer.flush();
+        }
+        more = readBatchBlock(reader, block, count, 1024);
+        answerBatchBlock(graph, *hierarchy, ctx, block, reportLatency, answers);
+        for (const string& answer : answers) {
+            writer.write(answer);
+        }
+        count += block.queries.size();
+    }
+    return count;
+}
+
+/************************* BatchReorderBuffer  **************************/
+
+/**
+ * @brief Window of answers computed out of order by the workers, released in input order.
+ *
+ * The window holds at most a fixed number of records in flight, so memory stays bounded however long the input is.
+ */
+class BatchReorderBuffer {
+public:
+    explicit BatchReorderBuffer(int capacity): answers(capacity), ready(capacity, false) {}
+
+    int getCapacity() const;
+
+    /**
+     * @brief Stores the answer of record seq. Called by the workers.
+     */
+    void put(int seq, string&& answer);
+
+    /**
+     * @brief Waits for the answer of record seq, the oldest one not yet released, and moves it to answer.
+     */
+    void take(int seq, string& answer);
+
+    /**
+     * @brief Moves the answer of record seq to answer if it is ready, without waiting.
+     */
+    bool tryTake(int seq, string& answer);
+
+private:
+    mutex lock;
+    condition_variable arrived;
+    vector<string> answers;     // answer of record seq at seq % capacity
+    vector<char> ready;
+};
+
+inline int BatchReorderBuffer::getCapacity() const {
+    return answers.size();
+}
+
+inline void BatchReorderBuffer::put(int seq, string&& answer) {
+    // Notified under the lock: once the last answer is taken the buffer may be destroyed, while a pool shared with
+    // other streams keeps this worker running
+    lock_guard<mutex> guard(lock);
+    answers[seq % answers.size()] = std::move(answer);
+    ready[seq % answers.size()] = true;
+    arrived.notify_all();
+}
+
+inline void BatchReorderBuffer::take(int seq, string& answer) {
+    unique_lock<mutex> guard(lock);
+    arrived.wait(guard, [&] { return ready[seq % answers.size()] != 0; });
+    answer.swap(answers[seq % answers.size()]);
+    ready[seq % answers.size()] = false;
+}
+
+inline bool BatchReorderBuffer::tryTake(int seq, string& answer) {
+    lock_guard<mutex> guard(lock);
+    if (!ready[seq % answers.size()]) {
+        return false;
+    }
+    answer.swap(answers[seq % answers.size()]);
+    ready[seq % answers.size()] = false;
+    return true;
+}
+
+/************************* BatchWorkers  **************************/
+
+/**
+ * @brief Thread pool answering batch records, with the search state of each of its workers. It can be shared by several
+ * streams, such as the clients of the query server, whose records then compete for the same workers instead of each
+ * stream starting its own.
+ */
+class BatchWorkers {
+public:
+    /**
+     * @brief Starts numThreads workers; 0 uses one per hardware thread.
+     */
+    explicit BatchWorkers(int numThreads): contexts(numThreads <= 0 ? ThreadPool::hardwareThreads() : numThreads), pool(contexts.size()) {}
+
+    ThreadPool& getPool();
+    SearchContext& getContext(int worker);
+    int getNumWorkers() const;
+
+private:
+    // Declared before the pool, so the workers are joined before the contexts are destroyed
+    vector<SearchContext> contexts;
+    ThreadPool pool;
+};
+
+inline ThreadPool& BatchWorkers::getPool() {
+    return pool;
+}
+
+inline SearchContext& BatchWorkers::getContext(int worker) {
+    return contexts[worker];
+}
+
+inline int BatchWorkers::getNumWorkers() const {
+    return contexts.size();
+}
+
+/**
+ * @brief Parallel version of processBatchStream. Records are still parsed one at a time by this thread, but their
+ * answers are computed by a work-stealing thread pool sharing the read-only graph, each worker with its own
+ * SearchContext. Records are read in blocks, as in processBatchStream, and each block is split so that the queries
+ * that share searches are answered by the same worker. Answers go through a reorder buffer, so the output is exactly
+ * the one of processBatchStream.
+ * At most 64 records per worker are in flight. Before waiting for more input every pending answer is written, as
+ * in processBatchStream.
+ *
+ * @param graph The graph representing the road network.
+ * @param in Stream with the query records.
+ * @param out Stream where the answers are written.
+ * @param numThreads Number of workers; 0 uses one per hardware thread. Ignored when workers is given.
+ * @param reportLatency Whether each answer ends with the time taken to answer it, counted from when its record was read.
+ * @param hierarchy Contraction hierarchy of graph shared with other streams, or nullptr to build one when needed.
+ * @param workers Workers shared with other streams, or nullptr to start numThreads of them for this stream.
+ * @return int Number of records answered.
+ */
+int processBatchStreamParallel(const CsrGraph<int>& graph, istream& in, ostream& out, int numThreads = 0, bool reportLatency = false, BatchHierarchy* hierarchy = nullptr, BatchWorkers* workers = nullptr) {
+    if (workers != nullptr) {
+        numThreads = workers->getNumWorkers();
+    } else if (numThreads <= 0) {
+        numThreads = ThreadPool::hardwareThreads();
+    }
+    BatchHierarchy ownHierarchy(graph);
+    if (hierarchy == nullptr) {
+        hierarchy = &ownHierarchy;
+    }
+    BatchReorderBuffer reorder(64 * numThreads);
+    // Declared after the buffer, so workers of its own are joined before what they write to is destroyed
+    unique_ptr<BatchWorkers> ownWorkers;
+    if (workers == nullptr) {
+        ownWorkers.reset(new BatchWorkers(numThreads));
+        workers = ownWorkers.get();
+    }
+    ThreadPool& pool = workers->getPool();
+    BatchReader reader(in);
+    BatchWriter writer(out);
+    BatchBlock block;
+    vector<BatchBlock> parts;
+    string answer;
+    int submitted = 0, emitted = 0;
+    bool more = true;
+    while (more) {
+        if (reader.isDrained()) {
+            for (; emitted < submitted; emitted++) {
+                reorder.take(emitted, answer);
+                writer.write(answer);
+            }
+            writer.flush();
+        }
+        if (submitted - emitted == reorder.getCapacity()) {
+            reorder.take(emitted++, answer);
+            writer.write(answer);
+        }
+        more = readBatchBlock(reader, block, submitted, reorder.getCapacity() - (submitted - emitted));
+        splitBatchBlock(graph, block, max<int>(1, block.queries.size() / numThreads), parts);
+        for (BatchBlock& part : parts) {
+            pool.submit([&graph, hierarchy, workers, &reorder, part = std::move(part), reportLatency](int worker) {
+                vector<string> answers;
+                answerBatchBlock(graph, *hierarchy, workers->getContext(worker), part, reportLatency, answers);
+                for (size_t i = 0; i < answers.size(); i++) {
+                    reorder.put(part.seqs[i], std::move(answers[i]));
+                }
+            });
+        }
+        submitted += block.queries.size();
+        while (emitted < submitted && reorder.tryTake(emitted, answer)) {
+            writer.write(answer);
+            emitted++;
+        }
+    }
+    for (; emitted < submitted; emitted++) {
+        reorder.take(emitted, answer);
+        writer.write(answer);
+    }
+    return submitted;
+}
+
+/**
+ * @brief Processes a batch mode operation for route planning.
+ * 
+ * Reads the query records from inputPath and writes their answers to outputPath ("-" for the standard input and output).
+ * By default these are "batchmode/input.txt" and "batchmode/output.txt". Supports different routing modes and constraints.
+ * With more than one thread the records are answered in parallel, with the same output.
+ * 
+ * @param graph The graph representing the road network.
+ * @param inputPath Path of the input, or "-".
+ * @param outputPath Path of the output, or "-".
+ * @param numThreads Number of threads; 0 uses one per hardware thread.
+ * @param walkingIndex Parking candidates of every vertex, read by the driving-walking queries it covers, or nullptr.
+ * @param landmarks Landmarks directing the searches of restricted queries, or nullptr.
+ * @param queue Queue of the driving-walking searches.
+ * @param allPairs All-pairs tables read by the unrestricted queries, or nullptr.
+ * @param overlay Overlay answering the restricted queries, or nullptr.
+ */
+void processBatchMode(const CsrGraph<int>& graph, const string& inputPath = "batchmode/input.txt", const string& outputPath = "batchmode/output.txt", int numThreads = 1, const WalkingIndex<int>* walkingIndex = nullptr, const Landmarks<int>* landmarks = nullptr, BatchQueue queue = HEAP_QUEUE, const AllPairs<int>* allPairs = nullptr, const MultiLevelOverlay<int>* overlay = nullptr) {
+    ifstream inputFile;
+    ofstream outputFile;
+    if (inputPath != "-") {
+        inputFile.open(inputPath);
+        if (!inputFile) {
+            cerr << "Error: Could not open input file.\n";
+            return;
+        }
+    }
+    if (outputPath != "-") {
+        outputFile.open(outputPath);
+    }
+    istream& in = inputPath == "-" ? cin : inputFile;
+    ostream& out = outputPath == "-" ? cout : outputFile;
+
+    if (numThreads == 0) {
+        numThreads = ThreadPool::hardwareThreads();
+    }
+    BatchHierarchy hierarchy(graph, walkingIndex, landmarks, queue, allPairs, overlay);
+    if (numThreads == 1) {
+        processBatchStream(graph, in, out, false, &hierarchy);
+    } else {
+        processBatchStreamParallel(graph, in, out, numThreads, false, &hierarchy);
+    }
+
+    if (outputPath != "-") {
+        outputFile.close();
+        cout << "\nBatch mode processing completed!\nPlease check output.txt \n";
+    }
+}
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "BatchMode.cpp"
+#include "../utils/FdStream.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <csignal>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+/**
+ * @brief Answers one client with the batch protocol: the client sends query records, in the batch input format, and
+ * receives their answers in order, each followed by its latency. Requests may be pipelined, records are read while
+ * earlier ones are still being answered.
+ *
+ * @param graph The graph representing the road network.
+ * @param in Stream with the client's records.
+ * @param out Stream where the answers are written.
+ * @param numThreads Number of threads answering the client's records; 0 uses one per hardware thread. Ignored when
+ * workers is given.
+ * @param hierarchy Contraction hierarchy of graph shared by every client.
+ * @param workers Workers shared by every client, or nullptr to answer this client with threads of its own.
+ * @return int Number of records answered.
+ */
+int serveQueries(const CsrGraph<int>& graph, istream& in, ostream& out, int numThreads, BatchHierarchy& hierarchy, BatchWorkers* workers = nullptr) {
+    if (workers != nullptr) {
+        return processBatchStreamParallel(graph, in, out, 0, true, &hierarchy, workers);
+    }
+    if (numThreads == 0) {
+        numThreads = ThreadPool::hardwareThreads();
+    }
+    if (numThreads == 1) {
+        return processBatchStream(graph, in, out, true, &hierarchy);
+    }
+    return processBatchStreamParallel(graph, in, out, numThreads, true, &hierarchy);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+/**
+ * @brief Largest number of clients the query server answers at once; further connections wait to be accepted.
+ */
+const int maxQueryClients = 64;
+
+/**
+ * @brief Opens a Unix socket at path, connected to a server if connect is set, or else listening for clients.
+ *
+ * @return int The socket descriptor, or -1 on error.
+ */
+int openUnixSocket(const string& path, bool connect) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        cerr << "Error: Socket path too long. " << path << "\n";
+        return -1;
+    }
+    strcpy(address.sun_path, path.c_str());
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) {
+        cerr << "Error: Could not create socket. " << strerror(errno) << "\n";
+        return -1;
+    }
+    if (connect) {
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1) {
+            cerr << "Error: Could not connect to " << path << ". " << strerror(errno) << "\n";
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+    unlink(path.c_str());
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1 || listen(fd, 16) == -1) {
+        cerr << "Error: Could not listen on " << path << ". " << strerror(errno) << "\n";
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Runs the query server on a Unix socket, reading each client on its own thread until the process is killed.
+ * The graph is loaded once, before the server starts, and shared read-only by every client. The records of every client
+ * are answered by one pool of numThreads workers, so concurrent clients share the cores instead of each starting a
+ * pool, and at most maxQueryClients clients are served at once.
+ *
+ * @param graph The graph representing the road network.
+ * @param path Path of the socket.
+ * @param numThreads Number of threads answering the records of every client; 0 uses one per hardware thread.
+ * @param walkingIndex Walking index of graph shared by every client, or nullptr.
+ * @param landmarks Landmarks of graph shared by every client, or nullptr.
+ * @param queue Queue of the driving-walking searches.
+ * @param allPairs All-pairs tables of graph shared by every client, or nullptr.
+ * @param overlay Overlay of graph shared by every client, or nullptr.
+ * @return int -1 if the socket can't be opened.
+ */
+int runQueryServer(const CsrGraph<int>& graph, const string& path, int numThreads, const WalkingIndex<int>* walkingIndex = nullptr, const Landmarks<int>* landmarks = nullptr, BatchQueue queue = HEAP_QUEUE, const AllPairs<int>* allPairs = nullptr, const MultiLevelOverlay<int>* overlay = nullptr) {
+    int server = openUnixSocket(path, false);
+    if (server == -1) {
+        return -1;
+    }
+    // A client that disconnects early makes writes fail instead of killing the server
+    signal(SIGPIPE, SIG_IGN);
+    cout << "Serving queries on " << path << "\n" << flush;
+    BatchHierarchy hierarchy(graph, walkingIndex, landmarks, queue, allPairs, overlay);
+    BatchWorkers workers(numThreads);
+    mutex clientsLock;
+    condition_variable clientLeft;
+    int clients = 0;
+    while (true) {
+        {
+            unique_lock<mutex> guard(clientsLock);
+            clientLeft.wait(guard, [&] { return clients < maxQueryClients; });
+        }
+        int client = accept(server, nullptr, nullptr);
+        if (client == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            cerr << "Error: Could not accept client. " << strerror(errno) << "\n";
+            close(server);
+            return -1;
+        }
+        {
+            lock_guard<mutex> guard(clientsLock);
+            clients++;
+        }
+        thread([&graph, &hierarchy, &workers, &clientsLock, &clientLeft, &clients, client, numThreads]() {
+            {
+                FdStreamBuf buffer(client);
+                istream in(&buffer);
+                ostream out(&buffer);
+                serveQueries(graph, in, out, numThreads, hierarchy, &workers);
+            }
+            close(client);
+            lock_guard<mutex> guard(clientsLock);
+            clients--;
+            clientLeft.notify_one();
+        }).detach();
+    }
+}
+
+/**
+ * @brief Minimal client for testing the server: sends every record read from in to the server at path, and copies
+ * the answers to out as they arrive.
+ *
+ * @return int 0 on success, -1 if the server can't be reached.
+ */
+int runQueryClient(const string& path, istream& in, ostream& out) {
+    int fd = openUnixSocket(path, true);
+    if (fd == -1) {
+        return -1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    thread receiver([fd, &out]() {
+        char block[1 << 16];
+        ssize_t n;
+        while ((n = read(fd, block, sizeof(block))) > 0 || (n == -1 && errno == EINTR)) {
+            if (n > 0) {
+                out.write(block, n);
+                out.flush();
+            }
+        }
+    });
+    string line;
+    while (getline(in, line)) {
+        line += "\n";
+        for (size_t sent = 0; sent < line.size();) {
+            ssize_t n = write(fd, line.data() + sent, line.size() - sent);
+            if (n <= 0) {
+                break;
+            }
+            sent += n;
+        }
+    }
+    shutdown(fd, SHUT_WR);
+    receiver.join();
+    close(fd);
+    return 0;
+}
+
+#else
+
+int runQueryServer(const CsrGraph<int>& graph, const string& path, int numThreads, const WalkingIndex<int>* walkingIndex = nullptr, const Landmarks<int>* landmarks = nullptr, BatchQueue queue = HEAP_QUEUE, const AllPairs<int>* allPairs = nullptr, const MultiLevelOverlay<int>* overlay = nullptr) {
+    cerr << "Error: Unix sockets are not available, use --serve - to serve on the standard input and output.\n";
+    return -1;
+}
+
+int runQueryClient(const string& path, istream& in, ostream& out) {
+    cerr << "Error: Unix sockets are not available.\n";
+    return -1;
+}
+
+#endif
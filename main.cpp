@@ -1,330 +1,493 @@
-#include <iostream>
-#include "utils/Graph.h"
-#include "batchmode/BatchMode.cpp" // Include the BatchMode header
-#include <string>
-#include <regex>
-
-using namespace std;
-
-/**
- * @brief Displays the main menu for the Route Planning Analysis Tool. This function prints the available options for the user to interact with the tool.
- *
- */
-void displayMenu() {
-    cout << "\n=====| Route Planning Analysis Tool |=====\n";
-    cout << "1. Independent Route Planning\n";
-    cout << "2. Restricted Route Planning\n";
-    cout << "3. Environmentally-Friendly Route Planning (driving and walking)\n";
-    cout << "4. Run batch mode\n"; // Add batch mode option
-    cout << "5. Exit\n";
-    cout << "Enter your option: ";
-}
-
-/**
- * @brief Verifies if a string is fully numeric, for parsing purposes.
- * 
- * @param str 
- * @return true 
- * @return false 
- */
-bool is_numeric(const std::string& str) {
-    return !str.empty() && std::all_of(str.begin(), str.end(), ::isdigit);
-}
-
-/**
- * @brief Reads the source and destination vertices from user input. This function prompts the user to input the IDs of the source and destination vertices. It validates the input to ensure the vertices exist in the graph.
- * 
- * @param g Reference to the graph object.
- * @param source Reference to a pointer where the source vertex will be stored.
- * @param destination Reference to a pointer where the destination vertex will be stored.
- */
-void readSourceAndDest (Graph<int> &g, Vertex<int>* &source, Vertex<int>* &destination) {
-    std::string sourceIdString, destinationIdString;
-    int sourceId, destinationId;
-
-    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-    
-    while (true) {
-        std::cout << "Source:";
-        std::getline(std::cin, sourceIdString);
-
-        if (!is_numeric(sourceIdString)) {
-            std::cout << "Invalid input! Please enter a number.\n";
-            continue;
-        }
-
-        try {
-            sourceId = std::stoi(sourceIdString);  // Attempt conversion
-
-            if (!(source = g.findVertexById(sourceId))) {
-                std::cout << "Error: Invalid source. Try again.\n";
-                continue;
-            }
-
-            break;  // Valid input, exit loop
-
-        } catch (const std::out_of_range&) {   // Input is above the int limit
-            std::cout << "Number out of range! Please enter a smaller number.\n";
-            continue;
-        }
-    }
-
-    while (true) {
-        std::cout << "Destination:";
-        std::getline(std::cin, destinationIdString);
-
-        if (!is_numeric(destinationIdString)) {
-            std::cout << "Invalid input! Please enter a number.\n";
-            continue;
-        }
-
-        try {
-            destinationId = std::stoi(destinationIdString);  
-
-            if (!(destination = g.findVertexById(destinationId))) {
-                std::cout << "Error: Invalid destination. Try again.\n";
-                continue;
-            }
-
-            break;  
-
-        } catch (const std::out_of_range&) {
-            std::cout << "Number out of range! Please enter a smaller number.\n";
-            continue;
-        }
-    }
-}
-
-/**
- * @brief Executes the independent route planning functionality.
- * 
- * @param g Reference to the graph object.
- */
-void independentRoute(Graph<int> &g) {
-    cout << "Finding best and alternative routes...\n";
-
-    Vertex<int>* source = nullptr;
-    Vertex<int>* destination = nullptr;
-
-    readSourceAndDest(g, source, destination);
-
-    list<int> bestPath = {}, altPath = {};
-    int bestTime = -1, altTime = -1;
-
-    // Find the Best Route
-    IndependentRoutePlanning(g, source, destination, bestPath, bestTime, altPath, altTime);
-
-    cout << "\n========| OUTPUT |========\n";
-    // Print Source and Destination
-    outputSourceDest(source->getId(), destination->getId(), cout);
-    // Print Best Route
-    cout << "BestDrivingRoute:";
-    outputPathAndCost(bestPath, bestTime, cout);
-    // Print Alternative Route
-    cout << "AlternativeDrivingRoute:";
-    outputPathAndCost(altPath, altTime, cout);
-}
-
-/**
- * @brief Executes the restricted route planning functionality.
- * 
- * @param g Reference to the graph object.
- */
-void restrictedRoute(Graph<int> &g) {
-    cout << "Finding restricted route...\n";
-
-    Vertex<int>* source = nullptr;
-    Vertex<int>* destination = nullptr;
-
-    readSourceAndDest(g, source, destination);
-
-    unordered_set<int> avoidNodes = {};
-    std::string input;
-
-    cout << "AvoidNodes:";
-    std::getline(std::cin, input); 
-
-    if (!input.empty()) {
-        stringstream ss(input);
-        string current;
-
-        while (std::getline(ss, current, ',')) {
-            avoidNodes.insert(stoi(current));
-        }
-    }
-        
-    unordered_set<pair<int, int>, pairHash> avoidEdges = {};
-    
-    cout << "AvoidSegments:";
-    std::getline(std::cin, input); 
-
-    if (!input.empty()) {
-        regex segmentRegex(R"(\((\d+),(\d+)\))");
-        smatch match;
-        string::const_iterator searchStart(input.cbegin());
-        while (regex_search(searchStart, input.cend(), match, segmentRegex)) {
-            try {
-                int from = stoi(match[1]);
-                int to = stoi(match[2]);
-                avoidEdges.insert({from, to});
-                searchStart = match.suffix().first;
-            } catch (invalid_argument& e) {
-                cout << "Error: Invalid edge to avoid. " << match[1] << "," << match[2] << "\n";
-                return;
-            }
-        }
-    }
-
-    int includeNode;
-
-    cout << "IncludeNode:";
-    std::getline(std::cin, input); 
-    
-    if (!input.empty()) {
-        includeNode = stoi(input);
-    }
-    
-    list<int> bestPath = {};
-    int bestTime = -1;
-    cout << "\n========| OUTPUT |========\n";
-    outputSourceDest(source->getId(), destination->getId(), cout);
-    int time = RestrictedRoutePlanning(g, source, destination, avoidNodes, avoidEdges, g.findVertexById(includeNode), bestPath);
-    cout << "RestrictedDrivingRoute:";
-    outputPathAndCost(bestPath, time, cout);
-    
-}
-
-/**
- * @brief Executes the environmentally-friendly route planning functionality.
- * 
- * @param g Reference to the graph object.
- */
-void EFriendlyRoute(Graph<int> &g) {
-    cout << "Finding environmentally-friendly route...\n";
-
-    Vertex<int>* source = nullptr;
-    Vertex<int>* destination = nullptr;
-
-    readSourceAndDest(g, source, destination);
-
-    int maxWalkTime;
-    std::string input;
-
-    cout << "MaxWalkTime:";
-    std::getline(std::cin, input); 
-    
-    if (input.empty()) maxWalkTime = std::numeric_limits<int>::max();
-    else maxWalkTime = stoi(input);
-
-    unordered_set<int> avoidNodes = {};
-
-    cout << "AvoidNodes:";
-    std::getline(std::cin, input); 
-
-    if (!input.empty()) {
-        stringstream ss(input);
-        string current;
-
-        while (std::getline(ss, current, ',')) {
-            avoidNodes.insert(stoi(current));
-        }
-    }
-        
-    unordered_set<pair<int, int>, pairHash> avoidEdges = {};
-    
-    cout << "AvoidSegments:";
-    std::getline(std::cin, input); 
-
-    if (!input.empty()) {
-        regex segmentRegex(R"(\((\d+),(\d+)\))");
-        smatch match;
-        string::const_iterator searchStart(input.cbegin());
-        while (regex_search(searchStart, input.cend(), match, segmentRegex)) {
-            try {
-                int from = stoi(match[1]);
-                int to = stoi(match[2]);
-                avoidEdges.insert({from, to});
-                searchStart = match.suffix().first;
-            } catch (invalid_argument& e) {
-                cout << "Error: Invalid edge to avoid. " << match[1] << "," << match[2] << "\n";
-                return;
-            }
-        }
-    }
-
-    list<int> path = {};
-    int parkingNodeId;
-    int walkingTime, drivingTime;
-    cout << "\n========| OUTPUT |========\n";
-    outputSourceDest(source->getId(), destination->getId(), cout);
-    int err = calculateEnvironmentallyFriendlyPath(g, source, destination, maxWalkTime, avoidNodes, avoidEdges, path, parkingNodeId, walkingTime, drivingTime);
-    if (err != 0) {
-        cout << "DrivingRoute:\nParkingNode:\nWalkingRoute:\nTotalTime:\nMessage:";
-        int parkingNodeId1, parkingNodeId2;
-        int walkingTime1 = std::numeric_limits<int>::max(), walkingTime2= std::numeric_limits<int>::max(), drivingTime1= std::numeric_limits<int>::max(), drivingTime2= std::numeric_limits<int>::max();
-        std::list<int> path1 = {}, path2 = {};
-        std::string message = AlternativeRoutes(g, source, destination, maxWalkTime, avoidNodes, avoidEdges, path1, parkingNodeId1, walkingTime1, drivingTime1, path2, parkingNodeId2, walkingTime2, drivingTime2);
-        cout << message << "\n";
-        outputDrivingWalkingPath(path1, parkingNodeId1, cout, drivingTime1, walkingTime1, "1");
-        outputDrivingWalkingPath(path2, parkingNodeId2, cout, drivingTime2, walkingTime2, "2");
-    } else if (err == 0) {
-        outputDrivingWalkingPath(path, parkingNodeId, cout, drivingTime, walkingTime, "");
-    }
-}
-
-/**
- * @brief Executes the batch mode functionality.
- * 
- * @param g Reference to the graph object.
- */
-void runBatchMode(Graph<int> &g) {
-    cout << "\n[ Running batch mode... ]\n";
-    Graph<int> graph;
-
-    // Initialize the graph
-    readParseLocations(graph);
-    readParseDistances(graph);
-
-    // Process batch mode
-    processBatchMode(graph);
-}
-
-/**
- * @brief Main function and entry point of the program.
- * 
- * This function initializes the graph, displays the main menu, and handles user input
- * to execute the selected route planning functionality. The program runs in a loop until
- * the user chooses to exit.
- * 
- * @return int Returns 0 upon successful execution.
- */
-int main() {
-    int option;
-    Graph<int> graph;
-
-    // Initialize the graph
-    readParseLocations(graph);
-    readParseDistances(graph);
-
-    while (true) {
-        displayMenu();
-        cin >> option;
-
-        if (cin.fail()) {  // Handle invalid input (e.g., letters instead of numbers)
-            cin.clear();
-            cin.ignore(10000, '\n');
-            cout << "Invalid input! Please enter a number between 1 and 6.\n";
-            continue;
-        }
-
-        switch (option) {
-            case 1: independentRoute(graph); break;
-            case 2: restrictedRoute(graph); break;
-            case 3: EFriendlyRoute(graph); break;
-            case 4: runBatchMode(graph); break; // Call batch mode
-            case 5: cout << "Exiting...\n"; return 0;
-            default: cout << "Invalid option! Please try again.\n";
-        }
-        cout << "\n";
-    }
+#include <iostream>
+#include "utils/Graph.h"
+#include "batchmode/BatchMode.cpp" // Include the BatchMode header
+#include "batchmode/QueryServer.cpp"
+#include <string>
+#include <regex>
+
+using namespace std;
+
+/**
+ * @brief Displays the main menu for the Route Planning Analysis Tool. This function prints the available options for the user to interact with the tool.
+ *
+ */
+void displayMenu() {
+    cout << "\n=====| Route Planning Analysis Tool |=====\n";
+    cout << "1. Independent Route Planning\n";
+    cout << "2. Restricted Route Planning\n";
+    cout << "3. Environmentally-Friendly Route Planning (driving and walking)\n";
+    cout << "4. Run batch mode\n"; // Add batch mode option
+    cout << "5. Exit\n";
+    cout << "Enter your option: ";
+}
+
+/**
+ * @brief Verifies if a string is fully numeric, for parsing purposes.
+ * 
+ * @param str 
+ * @return true 
+ * @return false 
+ */
+bool is_numeric(const std::string& str) {
+    return !str.empty() && std::all_of(str.begin(), str.end(), ::isdigit);
+}
+
+/**
+ * @brief Reads the source and destination vertices from user input. This function prompts the user to input the IDs of the source and destination vertices. It validates the input to ensure the vertices exist in the graph.
+ * 
+ * @param g Reference to the graph object.
+ * @param source Reference to an int where the slot of the source vertex will be stored.
+ * @param destination Reference to an int where the slot of the destination vertex will be stored.
+ */
+void readSourceAndDest (const CsrGraph<int> &g, int &source, int &destination) {
+    std::string sourceIdString, destinationIdString;
+    int sourceId, destinationId;
+
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    
+    while (true) {
+        std::cout << "Source:";
+        std::getline(std::cin, sourceIdString);
+
+        if (!is_numeric(sourceIdString)) {
+            std::cout << "Invalid input! Please enter a number.\n";
+            continue;
+        }
+
+        try {
+            sourceId = std::stoi(sourceIdString);  // Attempt conversion
+
+            if ((source = g.findSlotById(sourceId)) == -1) {
+                std::cout << "Error: Invalid source. Try again.\n";
+                continue;
+            }
+
+            break;  // Valid input, exit loop
+
+        } catch (const std::out_of_range&) {   // Input is above the int limit
+            std::cout << "Number out of range! Please enter a smaller number.\n";
+            continue;
+        }
+    }
+
+    while (true) {
+        std::cout << "Destination:";
+        std::getline(std::cin, destinationIdString);
+
+        if (!is_numeric(destinationIdString)) {
+            std::cout << "Invalid input! Please enter a number.\n";
+            continue;
+        }
+
+        try {
+            destinationId = std::stoi(destinationIdString);  
+
+            if ((destination = g.findSlotById(destinationId)) == -1) {
+                std::cout << "Error: Invalid destination. Try again.\n";
+                continue;
+            }
+
+            break;  
+
+        } catch (const std::out_of_range&) {
+            std::cout << "Number out of range! Please enter a smaller number.\n";
+            continue;
+        }
+    }
+}
+
+/**
+ * @brief Executes the independent route planning functionality.
+ * 
+ * @param ch Contraction hierarchy of the graph, used for the best route.
+ * @param allPairs All-pairs tables of the graph, used for the best route instead of ch, or nullptr if they weren't built.
+ * @param ctx Search state reused across queries.
+ */
+void independentRoute(const ContractionHierarchy<int> &ch, const AllPairs<int> *allPairs, SearchContext &ctx) {
+    const CsrGraph<int> &g = ch.getGraph();
+    cout << "Finding best and alternative routes...\n";
+
+    int source = -1;
+    int destination = -1;
+
+    readSourceAndDest(g, source, destination);
+
+    list<int> bestPath = {}, altPath = {};
+    int bestTime = -1, altTime = -1;
+
+    // Find the Best Route
+    if (allPairs != nullptr) {
+        IndependentRoutePlanning(*allPairs, ctx, source, destination, bestPath, bestTime, altPath, altTime);
+    } else {
+        IndependentRoutePlanning(ch, ctx, source, destination, bestPath, bestTime, altPath, altTime);
+    }
+
+    cout << "\n========| OUTPUT |========\n";
+    // Print Source and Destination
+    outputSourceDest(g.getId(source), g.getId(destination), cout);
+    // Print Best Route
+    cout << "BestDrivingRoute:";
+    outputPathAndCost(bestPath, bestTime, cout);
+    // Print Alternative Route
+    cout << "AlternativeDrivingRoute:";
+    outputPathAndCost(altPath, altTime, cout);
+}
+
+/**
+ * @brief Executes the restricted route planning functionality.
+ * 
+ * @param overlay Multi-level overlay of the graph, customized for each restriction.
+ * @param ctx Search state reused across queries.
+ */
+void restrictedRoute(const MultiLevelOverlay<int> &overlay, SearchContext &ctx) {
+    const CsrGraph<int> &g = overlay.getGraph();
+    cout << "Finding restricted route...\n";
+
+    int source = -1;
+    int destination = -1;
+
+    readSourceAndDest(g, source, destination);
+
+    unordered_set<int> avoidNodes = {};
+    std::string input;
+
+    cout << "AvoidNodes:";
+    std::getline(std::cin, input); 
+
+    if (!input.empty()) {
+        stringstream ss(input);
+        string current;
+
+        while (std::getline(ss, current, ',')) {
+            avoidNodes.insert(stoi(current));
+        }
+    }
+        
+    unordered_set<pair<int, int>, pairHash> avoidEdges = {};
+    
+    cout << "AvoidSegments:";
+    std::getline(std::cin, input); 
+
+    if (!input.empty()) {
+        regex segmentRegex(R"(\((\d+),(\d+)\))");
+        smatch match;
+        string::const_iterator searchStart(input.cbegin());
+        while (regex_search(searchStart, input.cend(), match, segmentRegex)) {
+            try {
+                int from = stoi(match[1]);
+                int to = stoi(match[2]);
+                avoidEdges.insert({from, to});
+                searchStart = match.suffix().first;
+            } catch (invalid_argument& e) {
+                cout << "Error: Invalid edge to avoid. " << match[1] << "," << match[2] << "\n";
+                return;
+            }
+        }
+    }
+
+    int includeNode = -1;
+
+    cout << "IncludeNode:";
+    std::getline(std::cin, input); 
+    
+    if (!input.empty()) {
+        includeNode = stoi(input);
+    }
+    
+    list<int> bestPath = {};
+    cout << "\n========| OUTPUT |========\n";
+    outputSourceDest(g.getId(source), g.getId(destination), cout);
+    int time = RestrictedRoutePlanning(overlay, ctx, source, destination, avoidNodes, avoidEdges, g.findSlotById(includeNode), bestPath);
+    cout << "RestrictedDrivingRoute:";
+    outputPathAndCost(bestPath, time, cout);
+    
+}
+
+/**
+ * @brief Executes the environmentally-friendly route planning functionality.
+ * 
+ * @param g Reference to the graph object.
+ * @param ctx Search state reused across queries.
+ * @param walkingIndex Walking index of the graph, read instead of the walking search when it covers the query, or nullptr.
+ * @param numThreads Number of threads searching for alternative routes; 0 uses one per hardware thread.
+ * @param landmarks Landmarks of the graph, directing the driving search, or nullptr.
+ * @param allPairs All-pairs tables of the graph, read instead of searching when there are no restrictions, or nullptr.
+ */
+void EFriendlyRoute(const CsrGraph<int> &g, SearchContext &ctx, const WalkingIndex<int> *walkingIndex, int numThreads, const Landmarks<int> *landmarks, const AllPairs<int> *allPairs) {
+    cout << "Finding environmentally-friendly route...\n";
+
+    int source = -1;
+    int destination = -1;
+
+    readSourceAndDest(g, source, destination);
+
+    int maxWalkTime;
+    std::string input;
+
+    cout << "MaxWalkTime:";
+    std::getline(std::cin, input); 
+    
+    if (input.empty()) maxWalkTime = std::numeric_limits<int>::max();
+    else maxWalkTime = stoi(input);
+
+    unordered_set<int> avoidNodes = {};
+
+    cout << "AvoidNodes:";
+    std::getline(std::cin, input); 
+
+    if (!input.empty()) {
+        stringstream ss(input);
+        string current;
+
+        while (std::getline(ss, current, ',')) {
+            avoidNodes.insert(stoi(current));
+        }
+    }
+        
+    unordered_set<pair<int, int>, pairHash> avoidEdges = {};
+    
+    cout << "AvoidSegments:";
+    std::getline(std::cin, input); 
+
+    if (!input.empty()) {
+        regex segmentRegex(R"(\((\d+),(\d+)\))");
+        smatch match;
+        string::const_iterator searchStart(input.cbegin());
+        while (regex_search(searchStart, input.cend(), match, segmentRegex)) {
+            try {
+                int from = stoi(match[1]);
+                int to = stoi(match[2]);
+                avoidEdges.insert({from, to});
+                searchStart = match.suffix().first;
+            } catch (invalid_argument& e) {
+                cout << "Error: Invalid edge to avoid. " << match[1] << "," << match[2] << "\n";
+                return;
+            }
+        }
+    }
+
+    list<int> path = {};
+    int parkingNodeId;
+    int walkingTime, drivingTime;
+    cout << "\n========| OUTPUT |========\n";
+    outputSourceDest(g.getId(source), g.getId(destination), cout);
+    int err = calculateEnvironmentallyFriendlyPath(g, ctx, source, destination, maxWalkTime, avoidNodes, avoidEdges, path, parkingNodeId, walkingTime, drivingTime, walkingIndex, landmarks, allPairs);
+    if (err != 0) {
+        cout << "DrivingRoute:\nParkingNode:\nWalkingRoute:\nTotalTime:\nMessage:";
+        int parkingNodeId1, parkingNodeId2;
+        int walkingTime1 = std::numeric_limits<int>::max(), walkingTime2= std::numeric_limits<int>::max(), drivingTime1= std::numeric_limits<int>::max(), drivingTime2= std::numeric_limits<int>::max();
+        std::list<int> path1 = {}, path2 = {};
+        std::string message = AlternativeRoutes(g, ctx, source, destination, maxWalkTime, avoidNodes, avoidEdges, path1, parkingNodeId1, walkingTime1, drivingTime1, path2, parkingNodeId2, walkingTime2, drivingTime2, numThreads);
+        cout << message << "\n";
+        outputDrivingWalkingPath(path1, parkingNodeId1, cout, drivingTime1, walkingTime1, "1");
+        outputDrivingWalkingPath(path2, parkingNodeId2, cout, drivingTime2, walkingTime2, "2");
+    } else if (err == 0) {
+        outputDrivingWalkingPath(path, parkingNodeId, cout, drivingTime, walkingTime, "");
+    }
+}
+
+/**
+ * @brief Executes the batch mode functionality.
+ * 
+ * @param g Reference to the graph object.
+ * @param walkingIndex Walking index of the graph, or nullptr.
+ * @param landmarks Landmarks of the graph, or nullptr.
+ * @param queue Queue of the driving-walking searches.
+ * @param allPairs All-pairs tables of the graph, or nullptr.
+ * @param overlay Overlay answering the restricted queries, or nullptr.
+ */
+void runBatchMode(const CsrGraph<int> &g, const WalkingIndex<int> *walkingIndex, const Landmarks<int> *landmarks, BatchQueue queue, const AllPairs<int> *allPairs, const MultiLevelOverlay<int> *overlay) {
+    cout << "\n[ Running batch mode... ]\n";
+
+    // Process batch mode
+    processBatchMode(g, "batchmode/input.txt", "batchmode/output.txt", 1, walkingIndex, landmarks, queue, allPairs, overlay);
+}
+
+/**
+ * @brief Loads the graph from the files given on the command line: a snapshot written with --write-snapshot,
+ * a locations and a distances CSV, or by default datasets/locations.csv and datasets/distances.csv.
+ * 
+ * @param files Paths given on the command line.
+ * @param graph Graph where the CSVs are read; it must outlive the snapshot built from them.
+ * @param snapshot Snapshot used by every search.
+ * @return int 0 on success, -1 if the files can't be read.
+ */
+int loadGraph(const vector<string> &files, Graph<int> &graph, CsrGraph<int> &snapshot) {
+    if (files.size() == 1 && CsrGraph<int>::isSnapshot(files[0])) {
+        return snapshot.readSnapshot(files[0]);
+    }
+    if (files.size() != 0 && files.size() != 2) {
+        cout << "Expected a graph snapshot or a locations and a distances CSV.\n";
+        return -1;
+    }
+    string locations = files.empty() ? "datasets/locations.csv" : files[0];
+    string distances = files.empty() ? "datasets/distances.csv" : files[1];
+    if (readParseLocations(graph, locations) == -1 || readParseDistances(graph, distances) == -1) {
+        return -1;
+    }
+    snapshot = CsrGraph<int>(graph);
+    return 0;
+}
+
+/**
+ * @brief Main function and entry point of the program.
+ * 
+ * This function initializes the graph, displays the main menu, and handles user input
+ * to execute the selected route planning functionality. The program runs in a loop until
+ * the user chooses to exit.
+ *
+ * Usage: route_planner [graph.bin | locations.csv distances.csv] [--write-snapshot graph.bin] [--batch]
+ *        [--batch-input path] [--batch-output path] [--threads n] [--serve socket | -] [--connect socket] [--all-pairs]
+ *        [--walk-index radius] [--landmarks k] [--queue heap | dial | radix] [--overlay]
+ * With --write-snapshot the loaded graph is saved as a binary snapshot, which later runs load in milliseconds.
+ * With --batch, batch mode runs once instead of the menu, answering every query record of the batch input
+ * ("-" reads the standard input and writes the standard output). --threads sets the number of threads answering
+ * the batch (by default one per hardware thread), or searching for the menu's alternative routes; the output doesn't
+ * depend on it.
+ * With --serve the graph is loaded once and queries in the batch format are answered, with their latency, until the
+ * process is killed: on a Unix socket, or on the standard input and output with "-". --connect sends the records
+ * read from the standard input to a server and prints the answers. With --all-pairs the driving and walking times
+ * between every pair of vertices are computed once, after reporting the memory they need, and the best routes without
+ * restrictions, driving or driving-walking, are read from them in the menu, batch mode and the server. With --walk-index the parking nodes within radius walking time of every vertex are indexed once,
+ * and driving-walking queries whose walk fits in it read their candidates from the index instead of searching for them.
+ * With --landmarks, k landmarks and their distance tables are computed once, and the searches of restricted driving
+ * queries (batch mode and server, without --overlay) and of the menu's driving-walking queries become A* searches over
+ * their lower bounds.
+ * --queue picks the priority queue of the driving-walking searches of batch mode and the server: the binary heap (the
+ * default), Dial's buckets or the radix heap. Between routes of the same times, another queue may pick another one.
+ * With --overlay the multi-level overlay of the menu's restricted routes is built once and also answers the restricted
+ * driving queries of batch mode and the server, instead of their bidirectional (or A*) searches. Times are the same;
+ * between routes of the same time another one may be picked. On Locations.csv each query is slower than the plain
+ * search, so it is meant for larger graphs.
+ * 
+ * @return int Returns 0 upon successful execution.
+ */
+int main(int argc, char *argv[]) {
+    int option;
+    vector<string> files;
+    string snapshotOutput;
+    string batchInput = "batchmode/input.txt", batchOutput = "batchmode/output.txt";
+    int threads = 0, walkRadius = -1, numLandmarks = 0;
+    string servePath, connectPath;
+    bool batch = false, allPairsTables = false, overlayRoutes = false;
+    BatchQueue queue = HEAP_QUEUE;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--write-snapshot" && i + 1 < argc) {
+            snapshotOutput = argv[++i];
+        } else if (arg == "--batch") {
+            batch = true;
+        } else if (arg == "--batch-input" && i + 1 < argc) {
+            batchInput = argv[++i];
+            batch = true;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = max(0, atoi(argv[++i]));
+        } else if (arg == "--serve" && i + 1 < argc) {
+            servePath = argv[++i];
+        } else if (arg == "--all-pairs") {
+            allPairsTables = true;
+        } else if (arg == "--walk-index" && i + 1 < argc) {
+            walkRadius = max(0, atoi(argv[++i]));
+        } else if (arg == "--landmarks" && i + 1 < argc) {
+            numLandmarks = max(0, atoi(argv[++i]));
+        } else if (arg == "--queue" && i + 1 < argc) {
+            string name = argv[++i];
+            if (name != "heap" && name != "dial" && name != "radix") {
+                cerr << "Error: Invalid queue " << name << ", expected heap, dial or radix.\n";
+                return 1;
+            }
+            queue = name == "dial" ? DIAL_QUEUE : name == "radix" ? RADIX_QUEUE : HEAP_QUEUE;
+        } else if (arg == "--overlay") {
+            overlayRoutes = true;
+        } else if (arg == "--connect" && i + 1 < argc) {
+            connectPath = argv[++i];
+        } else if (arg == "--batch-output" && i + 1 < argc) {
+            batchOutput = argv[++i];
+            batch = true;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (!connectPath.empty()) {
+        return runQueryClient(connectPath, cin, cout) == -1 ? 1 : 0;
+    }
+
+    // Initialize the graph and freeze it into the snapshot used by every search
+    Graph<int> graph;
+    CsrGraph<int> snapshot;
+    if (loadGraph(files, graph, snapshot) == -1) {
+        return 1;
+    }
+    if (!snapshotOutput.empty()) {
+        if (snapshot.writeSnapshot(snapshotOutput) == -1) {
+            return 1;
+        }
+        cout << "Snapshot written to " << snapshotOutput << "\n";
+        return 0;
+    }
+    // Index the parking nodes around every vertex if asked, shared by every mode
+    unique_ptr<WalkingIndex<int>> walkingIndex;
+    if (walkRadius != -1) {
+        walkingIndex.reset(new WalkingIndex<int>(snapshot, walkRadius, threads));
+        cerr << "Walking index built (" << walkingIndex->getNumEntries() << " entries)\n";
+    }
+    // Pick the landmarks if asked, their tables serve every restricted query
+    unique_ptr<Landmarks<int>> landmarks;
+    if (numLandmarks > 0) {
+        landmarks.reset(new Landmarks<int>(snapshot, numLandmarks));
+        cerr << "Landmarks built (" << landmarks->getNumLandmarks() << " landmarks)\n";
+    }
+    // Tabulate every pair if asked, the tables grow with the square of the number of vertices
+    unique_ptr<AllPairs<int>> allPairs;
+    if (allPairsTables) {
+        cerr << "Computing all-pairs tables (" << (AllPairs<int>::estimateMemory(snapshot.getNumVertex()) + (1 << 20) - 1) / (1 << 20) << " MiB)...\n";
+        allPairs.reset(new AllPairs<int>(snapshot, threads));
+    }
+    // Partition the graph if asked, restricted queries only re-customize the cells they touch
+    unique_ptr<MultiLevelOverlay<int>> overlay;
+    if (overlayRoutes) {
+        overlay.reset(new MultiLevelOverlay<int>(snapshot));
+    }
+    if (servePath == "-") {
+        BatchHierarchy hierarchy(snapshot, walkingIndex.get(), landmarks.get(), queue, allPairs.get(), overlay.get());
+        serveQueries(snapshot, cin, cout, threads, hierarchy);
+        return 0;
+    }
+    if (!servePath.empty()) {
+        return runQueryServer(snapshot, servePath, threads, walkingIndex.get(), landmarks.get(), queue, allPairs.get(), overlay.get()) == -1 ? 1 : 0;
+    }
+    if (batch) {
+        processBatchMode(snapshot, batchInput, batchOutput, threads, walkingIndex.get(), landmarks.get(), queue, allPairs.get(), overlay.get());
+        return 0;
+    }
+    SearchContext context;
+    // Contract the driving metric once for unrestricted queries
+    ContractionHierarchy<int> hierarchy(snapshot);
+    // The menu's restricted queries always use the overlay, batch mode only if asked
+    const MultiLevelOverlay<int> *batchOverlay = overlay.get();
+    if (!overlayRoutes) {
+        overlay.reset(new MultiLevelOverlay<int>(snapshot));
+    }
+
+    while (true) {
+        displayMenu();
+        cin >> option;
+
+        if (cin.fail()) {  // Handle invalid input (e.g., letters instead of numbers)
+            cin.clear();
+            cin.ignore(10000, '\n');
+            cout << "Invalid input! Please enter a number between 1 and 6.\n";
+            continue;
+        }
+
+        switch (option) {
+            case 1: independentRoute(hierarchy, allPairs.get(), context); break;
+            case 2: restrictedRoute(*overlay, context); break;
+            case 3: EFriendlyRoute(snapshot, context, walkingIndex.get(), threads, landmarks.get(), allPairs.get()); break;
+            case 4: runBatchMode(snapshot, walkingIndex.get(), landmarks.get(), queue, allPairs.get(), batchOverlay); break; // Call batch mode
+            case 5: cout << "Exiting...\n"; return 0;
+            default: cout << "Invalid option! Please try again.\n";
+        }
+        cout << "\n";
+    }
 }
\ No newline at end of file
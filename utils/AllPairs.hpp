@@ -0,0 +1,177 @@
+#pragma once
+
+#include "../utils/CsrGraph.hpp"
+#include "../utils/ThreadPool.h"
+#include "../utils/MinPlus.h"
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <list>
+#include <vector>
+
+/************************* AllPairs  **************************/
+
+/**
+ * @brief Driving and walking times between every pair of vertices of a CsrGraph, so unrestricted queries on small and
+ * medium graphs are answered by table lookup.
+ *
+ * Each metric is computed with a blocked Floyd-Warshall. The V×V table is split into tiles of tileSize×tileSize; for every
+ * diagonal tile k, the tile itself is updated first, then the tiles of row and column k in parallel, and then every other
+ * tile in parallel. Each tile update only reads three tiles, which stay in cache, and relaxes them row by row with the
+ * fastest min-plus kernel of the CPU (see MinPlus.h). Times and next hops live in flat row-major arrays, so a path is
+ * read in O(P), where P is its number of edges.
+ *
+ * The tables take estimateMemory(V) bytes, O(V²); building them takes O(V³/p) time with p threads.
+ *
+ * @tparam T type of the vertex ids
+ */
+template <class T>
+class AllPairs {
+public:
+    enum Metric { DRIVING = 0, WALKING = 1 };
+
+    static const int tileSize = 64;
+
+    /**
+     * @brief Bytes taken by the tables of a graph with numVertex vertices, to be checked before building them.
+     */
+    static std::size_t estimateMemory(int numVertex);
+
+    /**
+     * @brief Computes the tables of both metrics for g. g must outlive them.
+     *
+     * @param numThreads number of threads; 0 uses one per hardware thread
+     */
+    explicit AllPairs(const CsrGraph<T> &g, int numThreads = 0);
+
+    const CsrGraph<T> &getGraph() const;
+
+    /**
+     * @brief Time of the best path from source to dest in O(1), or -1 if there is no path.
+     */
+    int getTime(Metric metric, int source, int dest) const;
+
+    /**
+     * @brief Reads the best path from source to dest as ordered ids, in O(P) where P is its number of edges.
+     *
+     * @param path used to return the path, empty if there is none
+     * @return int time of the path, or -1 if there is no path
+     */
+    int getPath(Metric metric, int source, int dest, std::list<T> &path) const;
+
+protected:
+    const CsrGraph<T> &graph;
+    int n;
+    std::vector<int> dist[2];   // dist[metric][i * n + j], max int if j can't be reached from i
+    std::vector<int> next[2];   // slot after i on the best path from i to j, -1 if there is none
+    MinPlusRowKernel kernel;
+
+    void build(Metric metric, ThreadPool &pool);
+    void updateTile(Metric metric, int rowTile, int colTile, int kTile);
+};
+
+template <class T>
+std::size_t AllPairs<T>::estimateMemory(int numVertex) {
+    return 2 * 2 * sizeof(int) * (std::size_t) numVertex * numVertex;
+}
+
+template <class T>
+AllPairs<T>::AllPairs(const CsrGraph<T> &g, int numThreads): graph(g), n(g.getNumVertex()), kernel(getMinPlusRowKernel()) {
+    ThreadPool pool(numThreads);
+    build(DRIVING, pool);
+    build(WALKING, pool);
+}
+
+template <class T>
+const CsrGraph<T> &AllPairs<T>::getGraph() const {
+    return graph;
+}
+
+template <class T>
+int AllPairs<T>::getTime(Metric metric, int source, int dest) const {
+    if (source == -1 || dest == -1)
+        return -1;
+    int time = dist[metric][(std::size_t) source * n + dest];
+    return time == std::numeric_limits<int>::max() ? -1 : time;
+}
+
+template <class T>
+int AllPairs<T>::getPath(Metric metric, int source, int dest, std::list<T> &path) const {
+    path.clear();
+    int time = getTime(metric, source, dest);
+    if (time == -1)
+        return -1;
+    path.push_back(graph.getId(source));
+    for (int v = source; v != dest;) {
+        v = next[metric][(std::size_t) v * n + dest];
+        path.push_back(graph.getId(v));
+    }
+    return time;
+}
+
+/*
+ * Relaxes the tile (rowTile, colTile) through the vertices of tile kTile.
+ */
+template <class T>
+void AllPairs<T>::updateTile(Metric metric, int rowTile, int colTile, int kTile) {
+    const int inf = std::numeric_limits<int>::max();
+    int *d = dist[metric].data();
+    int *nx = next[metric].data();
+    int rowEnd = std::min(n, (rowTile + 1) * tileSize);
+    int colBegin = colTile * tileSize, colEnd = std::min(n, (colTile + 1) * tileSize);
+    int kEnd = std::min(n, (kTile + 1) * tileSize);
+    for (int k = kTile * tileSize; k < kEnd; k++) {
+        const int *dk = d + (std::size_t) k * n;
+        for (int i = rowTile * tileSize; i < rowEnd; i++) {
+            int *di = d + (std::size_t) i * n;
+            int dik = di[k];
+            if (dik == inf)
+                continue;
+            int *ni = nx + (std::size_t) i * n;
+            kernel(dik, ni[k], dk + colBegin, di + colBegin, ni + colBegin, colEnd - colBegin);
+        }
+    }
+}
+
+template <class T>
+void AllPairs<T>::build(Metric metric, ThreadPool &pool) {
+    const int inf = std::numeric_limits<int>::max();
+    std::vector<int> &d = dist[metric];
+    std::vector<int> &nx = next[metric];
+    d.assign((std::size_t) n * n, inf);
+    nx.assign((std::size_t) n * n, -1);
+    for (int v = 0; v < n; v++) {
+        d[(std::size_t) v * n + v] = 0;
+        nx[(std::size_t) v * n + v] = v;
+        for (int e = graph.outBegin(v); e < graph.outEnd(v); e++) {
+            int u = graph.getEdgeDest(e);
+            int time = metric == DRIVING ? graph.getDrivingTime(e) : graph.getWalkingTime(e);
+            if (time < d[(std::size_t) v * n + u]) {
+                d[(std::size_t) v * n + u] = time;
+                nx[(std::size_t) v * n + u] = u;
+            }
+        }
+    }
+
+    int tiles = (n + tileSize - 1) / tileSize;
+    for (int k = 0; k < tiles; k++) {
+        updateTile(metric, k, k, k);
+        for (int t = 0; t < tiles; t++) {
+            if (t == k)
+                continue;
+            pool.submit([this, metric, t, k](int) { updateTile(metric, k, t, k); });
+            pool.submit([this, metric, t, k](int) { updateTile(metric, t, k, k); });
+        }
+        pool.wait();
+        for (int i = 0; i < tiles; i++) {
+            if (i == k)
+                continue;
+            pool.submit([this, metric, i, k, tiles](int) {
+                for (int j = 0; j < tiles; j++)
+                    if (j != k)
+                        updateTile(metric, i, j, k);
+            });
+        }
+        pool.wait();
+    }
+}
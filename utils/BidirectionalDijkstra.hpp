@@ -0,0 +1,148 @@
+#pragma once
+
+#include "../utils/CsrGraph.hpp"
+#include "../utils/SlotPriorityQueue.h"
+#include "../utils/SearchContext.hpp"
+#include "../utils/GetDrivingPath.hpp"
+#include "../utils/PairHash.hpp"
+#include <unordered_set>
+#include <list>
+
+/**
+ * @brief Runs a bidirectional Dijkstra on the driving times, with a forward search from source over the outgoing edges and a
+ * backward search from dest over the incoming edges, while avoiding certain nodes and edges. The side whose last settled
+ * distance is smaller advances, and the search stops once the two last settled distances add up to at least the best
+ * source-dest distance seen so far. Worst case time complexity is O(log(V)(E+V)) where V is the number of vertices and E is the number of edges,
+ * but each side typically only explores a ball of half the route length.
+ *
+ * Restrictions are applied as in RestrictedDijkstra: every vertex entered except source is checked against avoid_nodes
+ * (so dest can't be avoided), and every edge is checked against avoid_edges in its driving direction.
+ *
+ * @tparam T
+ * @param g graph where the path will be found
+ * @param ctx search state of the calling thread; the forward and backward edges are left in its labels
+ * @param source slot of the initial node of the path
+ * @param dest slot of the final node of the path
+ * @param avoid_nodes nodes that the path can't go through
+ * @param avoid_edges edges that the path can't go through
+ * @param meetingNode used to return the slot where both searches meet on the best path, -1 if there is no path
+ * @return int driving time of the best path, or -1 if there is no path
+ */
+template <class T>
+int BidirectionalDijkstra(const CsrGraph<T>& g, SearchContext& ctx, int source, int dest, const std::unordered_set<T>& avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash>& avoid_edges, int& meetingNode) {
+    meetingNode = -1;
+    if (source == -1 || dest == -1) {
+        return -1;
+    }
+    SearchLabels& forward = ctx.getForward();
+    SearchLabels& backward = ctx.getBackward();
+    forward.reset(g.getNumVertex());
+    backward.reset(g.getNumVertex());
+    forward.setDist(source, 0);
+    if (source == dest) {
+        meetingNode = source;
+        return 0;
+    }
+    SearchRestrictions& restrictions = ctx.getRestrictions();
+    restrictions.set(g, avoid_nodes, avoid_edges);
+    if (restrictions.isNodeAvoided(dest)) {
+        return -1;
+    }
+    backward.setDist(dest, 0);
+    SlotPriorityQueue forwardQueue(forward.getDistArray(), forward.getQueueIndexArray());
+    SlotPriorityQueue backwardQueue(backward.getDistArray(), backward.getQueueIndexArray());
+    forwardQueue.insert(source);
+    backwardQueue.insert(dest);
+    long long best = std::numeric_limits<long long>::max();
+    int lastForward = 0, lastBackward = 0;
+    while (!forwardQueue.empty() && !backwardQueue.empty()) {
+        if (lastForward + (long long) lastBackward >= best) {
+            break;
+        }
+        if (lastForward <= lastBackward) {
+            int v = forwardQueue.extractMin();
+            forward.setProcessing(v, false);
+            forward.setVisited(v, true);
+            lastForward = forward.getDist(v);
+            for (int e = g.outBegin(v); e < g.outEnd(v); e++) {
+                int u = g.getEdgeDest(e);
+                if (g.getDrivingTime(e) == std::numeric_limits<int>::max() || (forward.isVisited(u)&&!forward.isProcessing(u)) || restrictions.isNodeAvoided(u) || restrictions.isEdgeAvoided(e)) {
+                    continue;
+                }
+                int cost = forward.getDist(v) + g.getDrivingTime(e);
+                if (forward.getDist(u) > cost) {
+                    forward.setDist(u, cost);
+                    forward.setPath(u, e);
+                    if (!forward.isVisited(u)) {
+                        forwardQueue.insert(u);
+                        forward.setVisited(u, true);
+                        forward.setProcessing(u, true);
+                    } else {
+                        forwardQueue.decreaseKey(u);
+                    }
+                }
+                if (backward.getDist(u) != std::numeric_limits<int>::max() && (long long) forward.getDist(u) + backward.getDist(u) < best) {
+                    best = (long long) forward.getDist(u) + backward.getDist(u);
+                    meetingNode = u;
+                }
+            }
+        } else {
+            int v = backwardQueue.extractMin();
+            backward.setProcessing(v, false);
+            backward.setVisited(v, true);
+            lastBackward = backward.getDist(v);
+            for (int i = g.inBegin(v); i < g.inEnd(v); i++) {
+                int u = g.getInOrig(i);
+                if (g.getInDrivingTime(i) == std::numeric_limits<int>::max() || (backward.isVisited(u)&&!backward.isProcessing(u)) || (u != source && restrictions.isNodeAvoided(u)) || restrictions.isEdgeAvoided(g.getInEdge(i))) {
+                    continue;
+                }
+                int cost = backward.getDist(v) + g.getInDrivingTime(i);
+                if (backward.getDist(u) > cost) {
+                    backward.setDist(u, cost);
+                    backward.setPath(u, g.getInEdge(i));
+                    if (!backward.isVisited(u)) {
+                        backwardQueue.insert(u);
+                        backward.setVisited(u, true);
+                        backward.setProcessing(u, true);
+                    } else {
+                        backwardQueue.decreaseKey(u);
+                    }
+                }
+                if (forward.getDist(u) != std::numeric_limits<int>::max() && (long long) forward.getDist(u) + backward.getDist(u) < best) {
+                    best = (long long) forward.getDist(u) + backward.getDist(u);
+                    meetingNode = u;
+                }
+            }
+        }
+    }
+    if (meetingNode == -1) {
+        return -1;
+    }
+    return best;
+}
+
+/**
+ * @brief After a BidirectionalDijkstra, reads the path from source to dest through the meeting node and puts it
+ * in front of the ids already in orderedIds. Runs in O(V) time where V is the number of vertices in the graph.
+ *
+ * @tparam T
+ * @param g graph where the search was performed
+ * @param ctx search state holding the forward and backward edges
+ * @param meetingNode slot where both searches met, -1 if there is no path
+ * @param orderedIds list where the ids of the vertices on the path will be put
+ */
+template <class T>
+void getBidirectionalPath(const CsrGraph<T>& g, const SearchContext& ctx, int meetingNode, std::list<T>& orderedIds) {
+    if (meetingNode == -1) {
+        orderedIds = {};
+        return;
+    }
+    std::list<T> path = {};
+    int aux_edge = ctx.getBackward().getPath(meetingNode);
+    while (aux_edge != -1) {
+        path.push_back(g.getId(g.getEdgeDest(aux_edge)));
+        aux_edge = ctx.getBackward().getPath(g.getEdgeDest(aux_edge));
+    }
+    getDrivingPath(g, ctx.getForward(), meetingNode, path);
+    orderedIds.splice(orderedIds.begin(), path);
+}
@@ -0,0 +1,196 @@
+/*
+ * BucketQueue.h
+ * Monotone integer priority queues over vertex slots, alternatives to SlotPriorityQueue for Dijkstra.
+ * Both keep the insert/extractMin/decreaseKey/empty interface. They rely on keys being non-negative
+ * integers and on no key smaller than the last extracted one ever being inserted, which holds for
+ * Dijkstra with non-negative edge weights.
+ *
+ * decreaseKey is lazy: the slot is inserted again under its new key, and entries whose key no longer
+ * matches the slot's current key are discarded when they reach the front.
+ */
+
+#ifndef DA_TP_CLASSES_BUCKETQUEUE
+#define DA_TP_CLASSES_BUCKETQUEUE
+
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Dial's bucket queue: one bucket per key in a circular array that covers [min key, min key + C],
+ * where C is the largest edge weight. The array grows on demand, so C does not need to be known.
+ * insert and decreaseKey are O(1), extractMin is O(1) amortized plus the gaps between consecutive keys.
+ */
+class DialQueue {
+    std::vector<std::vector<std::pair<int, int>>> buckets; // (slot, key at insertion)
+    unsigned cursor = 0;        // smallest key that may still be in the queue
+    unsigned size = 0;          // number of entries, including stale ones
+    const std::vector<int> &key;
+    bool isStale(const std::pair<int, int> &entry) const;
+    void grow(unsigned span);
+    void settle();
+public:
+    DialQueue(const std::vector<int> &key, std::vector<int> &queueIndex);
+    void insert(int x);
+    int extractMin();
+    void decreaseKey(int x);
+    bool empty();
+};
+
+inline DialQueue::DialQueue(const std::vector<int> &key, std::vector<int> &): buckets(64), key(key) {}
+
+inline bool DialQueue::isStale(const std::pair<int, int> &entry) const {
+    return key[entry.first] != entry.second;
+}
+
+/*
+ * Grows the circular array to a power of two larger than span and redistributes the entries.
+ */
+inline void DialQueue::grow(unsigned span) {
+    unsigned newSize = buckets.size();
+    while (newSize <= span)
+        newSize *= 2;
+    std::vector<std::vector<std::pair<int, int>>> old(newSize);
+    old.swap(buckets);
+    for (auto &bucket : old)
+        for (auto &entry : bucket)
+            buckets[entry.second & (newSize - 1)].push_back(entry);
+}
+
+/*
+ * Moves the cursor to the first bucket holding a valid entry, dropping stale entries on the way.
+ */
+inline void DialQueue::settle() {
+    while (size > 0) {
+        auto &bucket = buckets[cursor & (buckets.size() - 1)];
+        while (!bucket.empty() && isStale(bucket.back())) {
+            bucket.pop_back();
+            size--;
+        }
+        if (!bucket.empty())
+            return;
+        if (size > 0)
+            cursor++;
+    }
+}
+
+inline void DialQueue::insert(int x) {
+    unsigned k = key[x];
+    if (k - cursor >= buckets.size())
+        grow(k - cursor);
+    buckets[k & (buckets.size() - 1)].push_back({x, key[x]});
+    size++;
+}
+
+inline void DialQueue::decreaseKey(int x) {
+    insert(x);
+}
+
+inline bool DialQueue::empty() {
+    settle();
+    return size == 0;
+}
+
+inline int DialQueue::extractMin() {
+    settle();
+    auto &bucket = buckets[cursor & (buckets.size() - 1)];
+    int x = bucket.back().first;
+    bucket.pop_back();
+    size--;
+    return x;
+}
+
+/**
+ * @brief Radix heap: entries are kept in 33 buckets according to the highest bit in which their key differs
+ * from the last extracted key. Suited to large weight ranges, where Dial's array would be mostly empty.
+ * insert and decreaseKey are O(1), extractMin is O(log C) amortized where C is the largest edge weight.
+ */
+class RadixHeap {
+    std::vector<std::pair<int, int>> buckets[33]; // (slot, key at insertion)
+    unsigned last = 0;          // last extracted key
+    unsigned size = 0;          // number of entries, including stale ones
+    const std::vector<int> &key;
+    static int bucketOf(unsigned k, unsigned last);
+    bool isStale(const std::pair<int, int> &entry) const;
+    void settle();
+public:
+    RadixHeap(const std::vector<int> &key, std::vector<int> &queueIndex);
+    void insert(int x);
+    int extractMin();
+    void decreaseKey(int x);
+    bool empty();
+};
+
+inline RadixHeap::RadixHeap(const std::vector<int> &key, std::vector<int> &): key(key) {}
+
+inline int RadixHeap::bucketOf(unsigned k, unsigned last) {
+    unsigned diff = k ^ last;
+    int b = 0;
+    while (diff != 0) {
+        diff >>= 1;
+        b++;
+    }
+    return b;
+}
+
+inline bool RadixHeap::isStale(const std::pair<int, int> &entry) const {
+    return key[entry.first] != entry.second;
+}
+
+/*
+ * Makes bucket 0 hold the minimum, redistributing the first non-empty bucket around its smallest valid key.
+ */
+inline void RadixHeap::settle() {
+    while (size > 0) {
+        auto &first = buckets[0];
+        while (!first.empty() && isStale(first.back())) {
+            first.pop_back();
+            size--;
+        }
+        if (!first.empty())
+            return;
+        int i = 1;
+        while (i < 33 && buckets[i].empty())
+            i++;
+        if (i == 33)
+            return;
+        unsigned newLast = ~0u;
+        for (auto &entry : buckets[i])
+            if (!isStale(entry) && (unsigned) entry.second < newLast)
+                newLast = entry.second;
+        std::vector<std::pair<int, int>> moved;
+        moved.swap(buckets[i]);
+        if (newLast != ~0u)
+            last = newLast;
+        for (auto &entry : moved) {
+            if (isStale(entry)) {
+                size--;
+                continue;
+            }
+            buckets[bucketOf(entry.second, last)].push_back(entry);
+        }
+    }
+}
+
+inline void RadixHeap::insert(int x) {
+    buckets[bucketOf(key[x], last)].push_back({x, key[x]});
+    size++;
+}
+
+inline void RadixHeap::decreaseKey(int x) {
+    insert(x);
+}
+
+inline bool RadixHeap::empty() {
+    settle();
+    return size == 0;
+}
+
+inline int RadixHeap::extractMin() {
+    settle();
+    int x = buckets[0].back().first;
+    buckets[0].pop_back();
+    size--;
+    return x;
+}
+
+#endif /* DA_TP_CLASSES_BUCKETQUEUE */
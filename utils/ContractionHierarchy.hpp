@@ -0,0 +1,510 @@
+#pragma once
+
+#include "../utils/CsrGraph.hpp"
+#include "../utils/SlotPriorityQueue.h"
+#include "../utils/SearchContext.hpp"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+/************************* ContractionHierarchy  **************************/
+
+/**
+ * @brief Contraction Hierarchies over the driving times of a CsrGraph, for unrestricted point-to-point driving queries.
+ *
+ * Preprocessing contracts the vertices one at a time in order of importance (edge difference plus contracted neighbours,
+ * updated lazily). Contracting v adds a shortcut u->w for every pair of arcs u->v->w unless a local witness search finds a path
+ * from u to w avoiding v that is not longer. Every arc, original or shortcut, is kept in flat arrays. A shortcut remembers
+ * its two child arcs, so paths unpack back to the original edges of the snapshot.
+ *
+ * A query is a bidirectional Dijkstra that only follows arcs towards more important vertices. Each side stops once its smallest
+ * key reaches the best distance found, so only a small part of the graph is settled. Restrictions (avoid_nodes/avoid_edges)
+ * are not supported, since shortcuts may hide avoided vertices and edges.
+ *
+ * @tparam T type of the vertex ids
+ */
+template <class T>
+class ContractionHierarchy {
+public:
+    /**
+     * @brief Builds the hierarchy for g. g must outlive the hierarchy.
+     */
+    explicit ContractionHierarchy(const CsrGraph<T> &g);
+
+    const CsrGraph<T> &getGraph() const;
+    int getRank(int v) const;
+    int getNumArcs() const;
+
+    /**
+     * @brief Finds the driving time of the best path from source to dest.
+     *
+     * @param ctx search state of the calling thread; the arcs used by both searches are left in its labels
+     * @param source slot of the initial node of the path
+     * @param dest slot of the final node of the path
+     * @param meetingNode used to return the most important vertex on the best path, -1 if there is no path
+     * @return int driving time of the best path, or -1 if there is no path
+     */
+    int query(SearchContext &ctx, int source, int dest, int &meetingNode) const;
+
+    /**
+     * @brief After a query, unpacks the best path into the indexes of the original edges of the snapshot, in order.
+     * Runs in O(P) where P is the number of edges on the path.
+     */
+    void unpackPath(const SearchContext &ctx, int meetingNode, std::vector<int> &edges) const;
+
+    /**
+     * @brief Finds the driving times from every source to every target with the bucket-based many-to-many algorithm.
+     * A backward upward search from each target leaves (target, time) in a bucket at every vertex it settles; a forward
+     * upward search from each source then scans the buckets of the vertices it settles. Both use stall-on-demand.
+     * Runs in O((S+T)·U·log U + B), where U is the size of an upward search space and B the number of bucket entries scanned,
+     * instead of the S·T point-to-point queries. Paths are found on demand with query and unpackPath.
+     *
+     * @param ctx search state of the calling thread
+     * @param sources slots of the sources, -1 for a missing vertex
+     * @param targets slots of the targets, -1 for a missing vertex
+     * @param table used to return the times row by row: table[i * targets.size() + j] is the time from sources[i]
+     * to targets[j], or -1 if there is no path
+     */
+    void manyToMany(SearchContext &ctx, const std::vector<int> &sources, const std::vector<int> &targets, std::vector<int> &table) const;
+
+protected:
+    const CsrGraph<T> &graph;
+    std::vector<int> rank;          // contraction order of each slot
+
+    // every arc, original edges first and then shortcuts
+    std::vector<int> arcFrom;
+    std::vector<int> arcTo;
+    std::vector<int> arcWeight;
+    std::vector<int> arcEdge;       // original edge index, -1 for shortcuts
+    std::vector<int> arcFirst;      // child arcs of a shortcut (from->middle, middle->to), -1 for original edges
+    std::vector<int> arcSecond;
+
+    // search graphs, as CSR over arc indexes
+    std::vector<int> upOffset;      // arcs leaving each slot towards more important vertices
+    std::vector<int> upArc;
+    std::vector<int> downOffset;    // arcs entering each slot from more important vertices
+    std::vector<int> downArc;
+
+    // state used only while contracting
+    std::vector<std::vector<int>> outArcs;
+    std::vector<std::vector<int>> inArcs;
+    std::vector<char> contracted;
+    std::vector<int> witnessDist;
+    std::vector<int> witnessTouched;
+
+    int addArc(int from, int to, int weight, int edge, int first, int second);
+    void witnessSearch(int source, int skip, int maxDist, int settleLimit);
+    int contract(int v, bool simulate);
+    void buildSearchGraphs();
+    void unpackArc(int arc, std::vector<int> &edges) const;
+    void upwardSearch(SearchLabels &labels, int start, bool forward, std::vector<int> &settled) const;
+};
+
+template <class T>
+ContractionHierarchy<T>::ContractionHierarchy(const CsrGraph<T> &g): graph(g) {
+    int n = g.getNumVertex();
+    outArcs.assign(n, {});
+    inArcs.assign(n, {});
+    contracted.assign(n, false);
+    witnessDist.assign(n, std::numeric_limits<int>::max());
+    rank.assign(n, -1);
+    for (int e = 0; e < g.getNumEdges(); e++) {
+        if (g.getDrivingTime(e) == std::numeric_limits<int>::max() || g.getEdgeOrig(e) == g.getEdgeDest(e))
+            continue;
+        addArc(g.getEdgeOrig(e), g.getEdgeDest(e), g.getDrivingTime(e), e, -1, -1);
+    }
+
+    std::vector<int> contractedNeighbours(n, 0);
+    std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> order;
+    for (int v = 0; v < n; v++)
+        order.push({contract(v, true), v});
+    int next = 0;
+    while (!order.empty()) {
+        int v = order.top().second;
+        order.pop();
+        if (contracted[v])
+            continue;
+        // lazy update: contract v only if it is still the least important vertex
+        int priority = contract(v, true) + contractedNeighbours[v];
+        if (!order.empty() && priority > order.top().first) {
+            order.push({priority, v});
+            continue;
+        }
+        contract(v, false);
+        contracted[v] = true;
+        rank[v] = next++;
+        for (int a : outArcs[v])
+            if (!contracted[arcTo[a]])
+                contractedNeighbours[arcTo[a]]++;
+        for (int a : inArcs[v])
+            if (!contracted[arcFrom[a]])
+                contractedNeighbours[arcFrom[a]]++;
+    }
+
+    buildSearchGraphs();
+    outArcs.clear();
+    outArcs.shrink_to_fit();
+    inArcs.clear();
+    inArcs.shrink_to_fit();
+    witnessDist.clear();
+    witnessDist.shrink_to_fit();
+}
+
+template <class T>
+const CsrGraph<T> &ContractionHierarchy<T>::getGraph() const {
+    return graph;
+}
+
+template <class T>
+int ContractionHierarchy<T>::getRank(int v) const {
+    return rank[v];
+}
+
+template <class T>
+int ContractionHierarchy<T>::getNumArcs() const {
+    return arcFrom.size();
+}
+
+template <class T>
+int ContractionHierarchy<T>::addArc(int from, int to, int weight, int edge, int first, int second) {
+    int a = arcFrom.size();
+    arcFrom.push_back(from);
+    arcTo.push_back(to);
+    arcWeight.push_back(weight);
+    arcEdge.push_back(edge);
+    arcFirst.push_back(first);
+    arcSecond.push_back(second);
+    outArcs[from].push_back(a);
+    inArcs[to].push_back(a);
+    return a;
+}
+
+/*
+ * Local Dijkstra from source over the uncontracted vertices, never entering skip, stopping beyond maxDist or after
+ * settleLimit vertices. Distances are left in witnessDist, the slots it wrote in witnessTouched.
+ */
+template <class T>
+void ContractionHierarchy<T>::witnessSearch(int source, int skip, int maxDist, int settleLimit) {
+    for (int v : witnessTouched)
+        witnessDist[v] = std::numeric_limits<int>::max();
+    witnessTouched.clear();
+    std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> pq;
+    witnessDist[source] = 0;
+    witnessTouched.push_back(source);
+    pq.push({0, source});
+    int settled = 0;
+    while (!pq.empty() && settled < settleLimit) {
+        auto [d, v] = pq.top();
+        pq.pop();
+        if (d != witnessDist[v])
+            continue;
+        if (d > maxDist)
+            break;
+        settled++;
+        for (int a : outArcs[v]) {
+            int u = arcTo[a];
+            if (u == skip || contracted[u])
+                continue;
+            int cost = d + arcWeight[a];
+            if (cost < witnessDist[u]) {
+                if (witnessDist[u] == std::numeric_limits<int>::max())
+                    witnessTouched.push_back(u);
+                witnessDist[u] = cost;
+                pq.push({cost, u});
+            }
+        }
+    }
+}
+
+/*
+ * Contracts v, or only counts what contracting it would do if simulate is true.
+ * Returns the edge difference: shortcuts added minus arcs removed.
+ */
+template <class T>
+int ContractionHierarchy<T>::contract(int v, bool simulate) {
+    // cheapest arc from each uncontracted in-neighbour and to each uncontracted out-neighbour
+    std::unordered_map<int, int> bestIn, bestOut;
+    for (int a : inArcs[v]) {
+        int u = arcFrom[a];
+        if (contracted[u])
+            continue;
+        auto it = bestIn.find(u);
+        if (it == bestIn.end() || arcWeight[a] < arcWeight[it->second])
+            bestIn[u] = a;
+    }
+    for (int a : outArcs[v]) {
+        int w = arcTo[a];
+        if (contracted[w])
+            continue;
+        auto it = bestOut.find(w);
+        if (it == bestOut.end() || arcWeight[a] < arcWeight[it->second])
+            bestOut[w] = a;
+    }
+    int shortcuts = 0;
+    for (auto &in : bestIn) {
+        int u = in.first;
+        int maxDist = 0;
+        for (auto &out : bestOut)
+            if (out.first != u)
+                maxDist = std::max(maxDist, arcWeight[in.second] + arcWeight[out.second]);
+        if (maxDist == 0)
+            continue;
+        witnessSearch(u, v, maxDist, 500);
+        for (auto &out : bestOut) {
+            int w = out.first;
+            if (w == u)
+                continue;
+            int viaV = arcWeight[in.second] + arcWeight[out.second];
+            if (witnessDist[w] <= viaV)
+                continue;
+            shortcuts++;
+            if (!simulate)
+                addArc(u, w, viaV, -1, in.second, out.second);
+        }
+    }
+    return shortcuts - (int) bestIn.size() - (int) bestOut.size();
+}
+
+template <class T>
+void ContractionHierarchy<T>::buildSearchGraphs() {
+    int n = rank.size();
+    upOffset.assign(n + 1, 0);
+    downOffset.assign(n + 1, 0);
+    for (int a = 0; a < (int) arcFrom.size(); a++) {
+        if (rank[arcTo[a]] > rank[arcFrom[a]])
+            upOffset[arcFrom[a] + 1]++;
+        else
+            downOffset[arcTo[a] + 1]++;
+    }
+    for (int v = 0; v < n; v++) {
+        upOffset[v + 1] += upOffset[v];
+        downOffset[v + 1] += downOffset[v];
+    }
+    upArc.resize(upOffset[n]);
+    downArc.resize(downOffset[n]);
+    std::vector<int> upNext(upOffset.begin(), upOffset.end() - 1), downNext(downOffset.begin(), downOffset.end() - 1);
+    for (int a = 0; a < (int) arcFrom.size(); a++) {
+        if (rank[arcTo[a]] > rank[arcFrom[a]])
+            upArc[upNext[arcFrom[a]]++] = a;
+        else
+            downArc[downNext[arcTo[a]]++] = a;
+    }
+}
+
+template <class T>
+int ContractionHierarchy<T>::query(SearchContext &ctx, int source, int dest, int &meetingNode) const {
+    meetingNode = -1;
+    if (source == -1 || dest == -1) {
+        return -1;
+    }
+    SearchLabels &forward = ctx.getForward();
+    SearchLabels &backward = ctx.getBackward();
+    forward.reset(rank.size());
+    backward.reset(rank.size());
+    forward.setDist(source, 0);
+    backward.setDist(dest, 0);
+    SlotPriorityQueue forwardQueue(forward.getDistArray(), forward.getQueueIndexArray());
+    SlotPriorityQueue backwardQueue(backward.getDistArray(), backward.getQueueIndexArray());
+    forwardQueue.insert(source);
+    backwardQueue.insert(dest);
+    long long best = std::numeric_limits<long long>::max();
+    bool forwardDone = false, backwardDone = false;
+    bool forwardTurn = true;
+    while (!forwardDone || !backwardDone) {
+        if (forwardDone) forwardTurn = false;
+        if (backwardDone) forwardTurn = true;
+        SearchLabels &labels = forwardTurn ? forward : backward;
+        SearchLabels &other = forwardTurn ? backward : forward;
+        SlotPriorityQueue &pq = forwardTurn ? forwardQueue : backwardQueue;
+        bool &done = forwardTurn ? forwardDone : backwardDone;
+        forwardTurn = !forwardTurn;
+        if (pq.empty()) {
+            done = true;
+            continue;
+        }
+        int v = pq.extractMin();
+        labels.setProcessing(v, false);
+        labels.setVisited(v, true);
+        if (labels.getDist(v) >= best) {
+            done = true;
+            continue;
+        }
+        if (other.getDist(v) != std::numeric_limits<int>::max() && (long long) labels.getDist(v) + other.getDist(v) < best) {
+            best = (long long) labels.getDist(v) + other.getDist(v);
+            meetingNode = v;
+        }
+        const std::vector<int> &offset = (&labels == &forward) ? upOffset : downOffset;
+        const std::vector<int> &arcs = (&labels == &forward) ? upArc : downArc;
+        for (int i = offset[v]; i < offset[v + 1]; i++) {
+            int a = arcs[i];
+            int u = (&labels == &forward) ? arcTo[a] : arcFrom[a];
+            if (labels.isVisited(u) && !labels.isProcessing(u)) {
+                continue;
+            }
+            int cost = labels.getDist(v) + arcWeight[a];
+            if (labels.getDist(u) > cost) {
+                labels.setDist(u, cost);
+                labels.setPath(u, a);
+                if (!labels.isVisited(u)) {
+                    pq.insert(u);
+                    labels.setVisited(u, true);
+                    labels.setProcessing(u, true);
+                } else {
+                    pq.decreaseKey(u);
+                }
+            }
+        }
+    }
+    if (meetingNode == -1) {
+        return -1;
+    }
+    return best;
+}
+
+/*
+ * Appends the original edges of an arc, expanding shortcuts without recursion.
+ */
+template <class T>
+void ContractionHierarchy<T>::unpackArc(int arc, std::vector<int> &edges) const {
+    std::vector<int> stack = {arc};
+    while (!stack.empty()) {
+        int a = stack.back();
+        stack.pop_back();
+        if (arcEdge[a] != -1) {
+            edges.push_back(arcEdge[a]);
+        } else {
+            stack.push_back(arcSecond[a]);
+            stack.push_back(arcFirst[a]);
+        }
+    }
+}
+
+template <class T>
+void ContractionHierarchy<T>::unpackPath(const SearchContext &ctx, int meetingNode, std::vector<int> &edges) const {
+    edges.clear();
+    if (meetingNode == -1) {
+        return;
+    }
+    std::vector<int> upward;
+    int a = ctx.getForward().getPath(meetingNode);
+    while (a != -1) {
+        upward.push_back(a);
+        a = ctx.getForward().getPath(arcFrom[a]);
+    }
+    for (auto it = upward.rbegin(); it != upward.rend(); it++)
+        unpackArc(*it, edges);
+    a = ctx.getBackward().getPath(meetingNode);
+    while (a != -1) {
+        unpackArc(a, edges);
+        a = ctx.getBackward().getPath(arcTo[a]);
+    }
+}
+
+/*
+ * Settles the whole upward search space of start, along upward arcs if forward is set and backwards along downward arcs
+ * otherwise. A vertex that a more important settled neighbour reaches with a smaller time is stalled: its time is not
+ * the shortest one, so it is neither expanded nor reported. Every other settled slot is appended to settled.
+ */
+template <class T>
+void ContractionHierarchy<T>::upwardSearch(SearchLabels &labels, int start, bool forward, std::vector<int> &settled) const {
+    labels.reset(rank.size());
+    settled.clear();
+    labels.setDist(start, 0);
+    SlotPriorityQueue pq(labels.getDistArray(), labels.getQueueIndexArray());
+    pq.insert(start);
+    const std::vector<int> &offset = forward ? upOffset : downOffset;
+    const std::vector<int> &arcs = forward ? upArc : downArc;
+    const std::vector<int> &stallOffset = forward ? downOffset : upOffset;
+    const std::vector<int> &stallArcs = forward ? downArc : upArc;
+    while (!pq.empty()) {
+        int v = pq.extractMin();
+        labels.setProcessing(v, false);
+        labels.setVisited(v, true);
+        bool stalled = false;
+        for (int i = stallOffset[v]; i < stallOffset[v + 1] && !stalled; i++) {
+            int a = stallArcs[i];
+            int u = forward ? arcFrom[a] : arcTo[a];
+            stalled = labels.getDist(u) != std::numeric_limits<int>::max() && labels.getDist(u) + arcWeight[a] < labels.getDist(v);
+        }
+        if (stalled) {
+            continue;
+        }
+        settled.push_back(v);
+        for (int i = offset[v]; i < offset[v + 1]; i++) {
+            int a = arcs[i];
+            int u = forward ? arcTo[a] : arcFrom[a];
+            if (labels.isVisited(u) && !labels.isProcessing(u)) {
+                continue;
+            }
+            int cost = labels.getDist(v) + arcWeight[a];
+            if (labels.getDist(u) > cost) {
+                labels.setDist(u, cost);
+                labels.setPath(u, a);
+                if (!labels.isVisited(u)) {
+                    pq.insert(u);
+                    labels.setVisited(u, true);
+                    labels.setProcessing(u, true);
+                } else {
+                    pq.decreaseKey(u);
+                }
+            }
+        }
+    }
+}
+
+template <class T>
+void ContractionHierarchy<T>::manyToMany(SearchContext &ctx, const std::vector<int> &sources, const std::vector<int> &targets, std::vector<int> &table) const {
+    int n = rank.size();
+    int numTargets = targets.size();
+    table.assign(sources.size() * targets.size(), std::numeric_limits<int>::max());
+    std::vector<int> settled;
+
+    // buckets, as CSR over slots: the targets whose backward search settled each slot, with their time
+    std::vector<std::pair<int, int>> entries;   // (slot, index in entry lists) filled per target, then sorted by slot
+    std::vector<int> entryTarget, entryDist;
+    for (int j = 0; j < numTargets; j++) {
+        if (targets[j] == -1)
+            continue;
+        upwardSearch(ctx.getBackward(), targets[j], false, settled);
+        for (int v : settled) {
+            entries.push_back({v, entryTarget.size()});
+            entryTarget.push_back(j);
+            entryDist.push_back(ctx.getBackward().getDist(v));
+        }
+    }
+    std::vector<int> bucketOffset(n + 1, 0);
+    for (const auto &entry : entries)
+        bucketOffset[entry.first + 1]++;
+    for (int v = 0; v < n; v++)
+        bucketOffset[v + 1] += bucketOffset[v];
+    std::vector<int> bucketTarget(entries.size()), bucketDist(entries.size());
+    std::vector<int> next(bucketOffset.begin(), bucketOffset.end() - 1);
+    for (const auto &entry : entries) {
+        int k = next[entry.first]++;
+        bucketTarget[k] = entryTarget[entry.second];
+        bucketDist[k] = entryDist[entry.second];
+    }
+    entries.clear();
+    entries.shrink_to_fit();
+
+    for (size_t i = 0; i < sources.size(); i++) {
+        if (sources[i] == -1)
+            continue;
+        int *row = table.data() + i * numTargets;
+        upwardSearch(ctx.getForward(), sources[i], true, settled);
+        for (int v : settled) {
+            int dist = ctx.getForward().getDist(v);
+            for (int k = bucketOffset[v]; k < bucketOffset[v + 1]; k++) {
+                if (dist + bucketDist[k] < row[bucketTarget[k]])
+                    row[bucketTarget[k]] = dist + bucketDist[k];
+            }
+        }
+    }
+    for (int &time : table) {
+        if (time == std::numeric_limits<int>::max())
+            time = -1;
+    }
+}
@@ -0,0 +1,425 @@
+#pragma once
+
+#include "Graph.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+/************************* CsrGraph  **************************/
+
+/**
+ * @brief Immutable compressed-sparse-row snapshot of a Graph, used by every search algorithm.
+ *
+ * Vertices are identified by a dense slot (their index in the graph's vertex set when the snapshot was built)
+ * and edges by a dense index into the outgoing arrays. Outgoing edges of slot v are [outBegin(v), outEnd(v)),
+ * incoming edges of slot v are [inBegin(v), inEnd(v)) and map back to the outgoing edge index with getInEdge.
+ * Both directions keep the adjacency order of the original graph, so searches break ties the same way.
+ *
+ * A snapshot can be saved to a binary file and read back without the CSVs (see writeSnapshot). A graph read that way has
+ * no Vertex/Edge objects behind it, so getVertex and getEdge return nullptr.
+ *
+ * @tparam T type of the vertex ids
+ */
+template <class T>
+class CsrGraph {
+public:
+    CsrGraph() = default;
+    explicit CsrGraph(const Graph<T> &g);
+
+    int getNumVertex() const;
+    int getNumEdges() const;
+
+    /**
+     * @brief Finds the slot of the vertex with a given id in O(1), or -1 if there is none.
+     */
+    int findSlotById(const T &id) const;
+    T getId(int v) const;
+    bool getParking(int v) const;
+    std::string getLocation(int v) const;
+    std::string getCode(int v) const;
+    Vertex<T> *getVertex(int v) const;
+
+    int outBegin(int v) const;
+    int outEnd(int v) const;
+    int getEdgeOrig(int e) const;
+    int getEdgeDest(int e) const;
+    int getDrivingTime(int e) const;
+    int getWalkingTime(int e) const;
+    Edge<T> *getEdge(int e) const;
+
+    int inBegin(int v) const;
+    int inEnd(int v) const;
+    int getInEdge(int i) const;
+    int getInOrig(int i) const;
+    int getInDrivingTime(int i) const;
+    int getInWalkingTime(int i) const;
+
+    /**
+     * @brief Saves the snapshot to a binary file: a header (magic, format version, byte order, id size, counts and a checksum
+     * of the rest) followed by every array of the snapshot, each padded to 8 bytes. Runs in O(V+E).
+     *
+     * @return int 0 on success, -1 if the file can't be written
+     */
+    int writeSnapshot(const std::string &path) const;
+
+    /**
+     * @brief Replaces this snapshot with one saved by writeSnapshot. The file is memory-mapped and each array is copied
+     * as a block, after checking the header and the checksum. Runs in O(V+E) with no parsing.
+     *
+     * @return int 0 on success, -1 (with a message) if the file can't be read, is from another format version or machine,
+     * or is corrupt; this snapshot is then left unchanged
+     */
+    int readSnapshot(const std::string &path);
+
+    /**
+     * @brief Tells whether the file at path starts like a snapshot, to tell it apart from a CSV.
+     */
+    static bool isSnapshot(const std::string &path);
+
+protected:
+    std::vector<T> ids;                 // id of the vertex in each slot
+    std::vector<char> parking;          // parking flag of each slot
+    std::vector<char> names;            // location and code of every slot, back to back
+    std::vector<int> nameOffset;        // location of slot v is [2v, 2v+1), its code [2v+1, 2v+2); size 2V+1
+    std::vector<Vertex<T> *> vertices;  // original vertex of each slot, empty if read from a file
+    std::vector<int> slotById;          // slot of each id, -1 if unused
+
+    // outgoing edges, grouped by origin
+    std::vector<int> outOffset;         // size V+1
+    std::vector<int> outOrig;
+    std::vector<int> outDest;
+    std::vector<int> outDriving;
+    std::vector<int> outWalking;
+    std::vector<Edge<T> *> edges;       // original edge of each outgoing index, empty if read from a file
+
+    // incoming edges, grouped by destination
+    std::vector<int> inOffset;          // size V+1
+    std::vector<int> inEdge;            // outgoing index of the same edge
+    std::vector<int> inOrig;
+    std::vector<int> inDriving;
+    std::vector<int> inWalking;
+
+    struct SnapshotHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byteOrder;        // 0x01020304 as written by the machine that saved it
+        std::uint32_t idSize;
+        std::uint32_t numVertex;
+        std::uint32_t numEdges;
+        std::uint32_t namesSize;
+        std::uint32_t idRange;          // size of slotById
+        std::uint32_t reserved;
+        std::uint64_t payloadSize;      // bytes after the header
+        std::uint64_t checksum;         // of the bytes after the header
+    };
+    static const std::uint32_t snapshotVersion = 1;
+
+    static std::uint64_t checksum(const char *data, std::size_t size);
+};
+
+/*
+ * Builds the snapshot in O(V+E). Slots follow the order of the graph's vertex set and
+ * edges follow the order of each vertex's adjacency and incoming lists.
+ */
+template <class T>
+CsrGraph<T>::CsrGraph(const Graph<T> &g) {
+    std::vector<Vertex<T> *> vertexSet = g.getVertexSet();
+    int n = vertexSet.size();
+    ids.reserve(n);
+    parking.reserve(n);
+    vertices = vertexSet;
+    std::unordered_map<const Vertex<T> *, int> slotOf;
+    slotOf.reserve(n);
+    nameOffset.reserve(2 * n + 1);
+    nameOffset.push_back(0);
+    for (int v = 0; v < n; v++) {
+        ids.push_back(vertexSet[v]->getId());
+        parking.push_back(vertexSet[v]->getParking());
+        for (const std::string &name : {vertexSet[v]->getLocation(), vertexSet[v]->getCode()}) {
+            names.insert(names.end(), name.begin(), name.end());
+            nameOffset.push_back(names.size());
+        }
+        slotOf[vertexSet[v]] = v;
+        T id = vertexSet[v]->getId();
+        if (id < 0)
+            continue;
+        if (static_cast<std::size_t>(id) >= slotById.size())
+            slotById.resize(id + 1, -1);
+        if (slotById[id] == -1)
+            slotById[id] = v;
+    }
+
+    std::unordered_map<const Edge<T> *, int> edgeIndex;
+    outOffset.assign(n + 1, 0);
+    for (int v = 0; v < n; v++) {
+        for (Edge<T> *e : vertexSet[v]->getAdj()) {
+            edgeIndex[e] = edges.size();
+            edges.push_back(e);
+            outOrig.push_back(v);
+            outDest.push_back(slotOf[e->getDest()]);
+            outDriving.push_back(e->getDrivingTime());
+            outWalking.push_back(e->getWalkingTime());
+        }
+        outOffset[v + 1] = edges.size();
+    }
+
+    inOffset.assign(n + 1, 0);
+    for (int v = 0; v < n; v++) {
+        for (Edge<T> *e : vertexSet[v]->getIncoming()) {
+            int idx = edgeIndex[e];
+            inEdge.push_back(idx);
+            inOrig.push_back(outOrig[idx]);
+            inDriving.push_back(outDriving[idx]);
+            inWalking.push_back(outWalking[idx]);
+        }
+        inOffset[v + 1] = inEdge.size();
+    }
+}
+
+template <class T>
+int CsrGraph<T>::getNumVertex() const {
+    return ids.size();
+}
+
+template <class T>
+int CsrGraph<T>::getNumEdges() const {
+    return outDest.size();
+}
+
+template <class T>
+int CsrGraph<T>::findSlotById(const T &id) const {
+    if (id < 0 || static_cast<std::size_t>(id) >= slotById.size())
+        return -1;
+    return slotById[id];
+}
+
+template <class T>
+T CsrGraph<T>::getId(int v) const {
+    return ids[v];
+}
+
+template <class T>
+bool CsrGraph<T>::getParking(int v) const {
+    return parking[v];
+}
+
+template <class T>
+std::string CsrGraph<T>::getLocation(int v) const {
+    return std::string(names.data() + nameOffset[2 * v], nameOffset[2 * v + 1] - nameOffset[2 * v]);
+}
+
+template <class T>
+std::string CsrGraph<T>::getCode(int v) const {
+    return std::string(names.data() + nameOffset[2 * v + 1], nameOffset[2 * v + 2] - nameOffset[2 * v + 1]);
+}
+
+template <class T>
+Vertex<T> *CsrGraph<T>::getVertex(int v) const {
+    return vertices.empty() ? nullptr : vertices[v];
+}
+
+template <class T>
+int CsrGraph<T>::outBegin(int v) const {
+    return outOffset[v];
+}
+
+template <class T>
+int CsrGraph<T>::outEnd(int v) const {
+    return outOffset[v + 1];
+}
+
+template <class T>
+int CsrGraph<T>::getEdgeOrig(int e) const {
+    return outOrig[e];
+}
+
+template <class T>
+int CsrGraph<T>::getEdgeDest(int e) const {
+    return outDest[e];
+}
+
+template <class T>
+int CsrGraph<T>::getDrivingTime(int e) const {
+    return outDriving[e];
+}
+
+template <class T>
+int CsrGraph<T>::getWalkingTime(int e) const {
+    return outWalking[e];
+}
+
+template <class T>
+Edge<T> *CsrGraph<T>::getEdge(int e) const {
+    return edges.empty() ? nullptr : edges[e];
+}
+
+template <class T>
+int CsrGraph<T>::inBegin(int v) const {
+    return inOffset[v];
+}
+
+template <class T>
+int CsrGraph<T>::inEnd(int v) const {
+    return inOffset[v + 1];
+}
+
+template <class T>
+int CsrGraph<T>::getInEdge(int i) const {
+    return inEdge[i];
+}
+
+template <class T>
+int CsrGraph<T>::getInOrig(int i) const {
+    return inOrig[i];
+}
+
+template <class T>
+int CsrGraph<T>::getInDrivingTime(int i) const {
+    return inDriving[i];
+}
+
+template <class T>
+int CsrGraph<T>::getInWalkingTime(int i) const {
+    return inWalking[i];
+}
+
+/*
+ * FNV-1a over 8-byte words; size must be a multiple of 8.
+ */
+template <class T>
+std::uint64_t CsrGraph<T>::checksum(const char *data, std::size_t size) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (std::size_t i = 0; i < size; i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    return hash;
+}
+
+template <class T>
+int CsrGraph<T>::writeSnapshot(const std::string &path) const {
+    static_assert(std::is_trivially_copyable<T>::value, "snapshots store the ids as raw bytes");
+    std::vector<char> payload;
+    auto append = [&payload](const auto &array) {
+        std::size_t bytes = array.size() * sizeof(array[0]);
+        std::size_t at = payload.size();
+        payload.resize(at + (bytes + 7) / 8 * 8, 0);
+        if (bytes > 0)
+            std::memcpy(payload.data() + at, array.data(), bytes);
+    };
+    append(ids);
+    append(parking);
+    append(names);
+    append(nameOffset);
+    append(slotById);
+    append(outOffset);
+    append(outOrig);
+    append(outDest);
+    append(outDriving);
+    append(outWalking);
+    append(inOffset);
+    append(inEdge);
+    append(inOrig);
+    append(inDriving);
+    append(inWalking);
+
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, "DAGRAPH", 8);
+    header.version = snapshotVersion;
+    header.byteOrder = 0x01020304;
+    header.idSize = sizeof(T);
+    header.numVertex = getNumVertex();
+    header.numEdges = getNumEdges();
+    header.namesSize = names.size();
+    header.idRange = slotById.size();
+    header.payloadSize = payload.size();
+    header.checksum = checksum(payload.data(), payload.size());
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cout << "Error opening file " << path << "!\n";
+        return -1;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(payload.data(), payload.size());
+    return file.good() ? 0 : -1;
+}
+
+template <class T>
+bool CsrGraph<T>::isSnapshot(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[8] = {};
+    file.read(magic, 8);
+    return file.good() && std::memcmp(magic, "DAGRAPH", 8) == 0;
+}
+
+template <class T>
+int CsrGraph<T>::readSnapshot(const std::string &path) {
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        std::cout << "Error opening file " << path << "!\n";
+        return -1;
+    }
+    SnapshotHeader header;
+    if (file.size() < sizeof(header)) {
+        std::cout << path << ": not a graph snapshot\n";
+        return -1;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, "DAGRAPH", 8) != 0) {
+        std::cout << path << ": not a graph snapshot\n";
+        return -1;
+    }
+    if (header.version != snapshotVersion || header.byteOrder != 0x01020304 || header.idSize != sizeof(T)) {
+        std::cout << path << ": snapshot written by another version or machine, regenerate it from the CSVs\n";
+        return -1;
+    }
+    const char *payload = file.data() + sizeof(header);
+    if (header.payloadSize != file.size() - sizeof(header) || header.payloadSize % 8 != 0 || checksum(payload, header.payloadSize) != header.checksum) {
+        std::cout << path << ": snapshot is corrupt (checksum mismatch)\n";
+        return -1;
+    }
+
+    CsrGraph<T> g;
+    std::size_t at = 0;
+    bool fits = true;
+    auto take = [&](auto &array, std::size_t count) {
+        std::size_t bytes = count * sizeof(array[0]);
+        if (!fits || at + bytes > header.payloadSize) {
+            fits = false;
+            return;
+        }
+        array.resize(count);
+        if (bytes > 0)
+            std::memcpy(array.data(), payload + at, bytes);
+        at += (bytes + 7) / 8 * 8;
+    };
+    std::size_t n = header.numVertex, m = header.numEdges;
+    take(g.ids, n);
+    take(g.parking, n);
+    take(g.names, header.namesSize);
+    take(g.nameOffset, 2 * n + 1);
+    take(g.slotById, header.idRange);
+    take(g.outOffset, n + 1);
+    take(g.outOrig, m);
+    take(g.outDest, m);
+    take(g.outDriving, m);
+    take(g.outWalking, m);
+    take(g.inOffset, n + 1);
+    take(g.inEdge, m);
+    take(g.inOrig, m);
+    take(g.inDriving, m);
+    take(g.inWalking, m);
+    if (!fits || at != header.payloadSize || g.nameOffset[2 * n] != (int) header.namesSize || g.outOffset[n] != (int) m || g.inOffset[n] != (int) m) {
+        std::cout << path << ": snapshot is corrupt (unexpected size)\n";
+        return -1;
+    }
+    *this = std::move(g);
+    return 0;
+}
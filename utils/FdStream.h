@@ -0,0 +1,104 @@
+/*
+ * FdStream.h
+ * Stream buffer over a POSIX file descriptor, such as a connected socket, so it can be read and written
+ * with std::istream and std::ostream. Reads and writes go through 64 KiB buffers.
+ */
+
+#ifndef DA_TP_CLASSES_FDSTREAM
+#define DA_TP_CLASSES_FDSTREAM
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <cerrno>
+#include <streambuf>
+#include <vector>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+class FdStreamBuf : public std::streambuf {
+public:
+    /*
+     * The descriptor is not owned, it's left open when the buffer is destroyed.
+     */
+    explicit FdStreamBuf(int fd);
+    FdStreamBuf(const FdStreamBuf &) = delete;
+    FdStreamBuf &operator=(const FdStreamBuf &) = delete;
+    ~FdStreamBuf() override;
+
+protected:
+    int_type underflow() override;
+    int_type overflow(int_type c) override;
+    int sync() override;
+    /*
+     * Bytes that can be read without blocking, so in_avail tells whether more input is already waiting.
+     */
+    std::streamsize showmanyc() override;
+
+private:
+    int fd;
+    std::vector<char> input;
+    std::vector<char> output;
+
+    bool flushOutput();
+};
+
+inline FdStreamBuf::FdStreamBuf(int fd): fd(fd), input(1 << 16), output(1 << 16) {
+    setg(input.data(), input.data(), input.data());
+    setp(output.data(), output.data() + output.size());
+}
+
+inline FdStreamBuf::~FdStreamBuf() {
+    flushOutput();
+}
+
+inline FdStreamBuf::int_type FdStreamBuf::underflow() {
+    if (gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+    ssize_t n;
+    do {
+        n = ::read(fd, input.data(), input.size());
+    } while (n == -1 && errno == EINTR);
+    if (n <= 0)
+        return traits_type::eof();
+    setg(input.data(), input.data(), input.data() + n);
+    return traits_type::to_int_type(*gptr());
+}
+
+inline FdStreamBuf::int_type FdStreamBuf::overflow(int_type c) {
+    if (!flushOutput())
+        return traits_type::eof();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+inline int FdStreamBuf::sync() {
+    return flushOutput() ? 0 : -1;
+}
+
+inline std::streamsize FdStreamBuf::showmanyc() {
+    int available = 0;
+    if (ioctl(fd, FIONREAD, &available) == -1)
+        return 0;
+    return available;
+}
+
+inline bool FdStreamBuf::flushOutput() {
+    const char *data = pbase();
+    while (data < pptr()) {
+        ssize_t n = ::write(fd, data, pptr() - data);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        data += n;
+    }
+    setp(output.data(), output.data() + output.size());
+    return true;
+}
+
+#endif
+
+#endif /* DA_TP_CLASSES_FDSTREAM */
@@ -1,26 +1,29 @@
 #pragma once
 
-#include "Graph.h"
+#include "CsrGraph.hpp"
+#include "SearchContext.hpp"
 #include <list>
 
 /**
- * @brief Read the path that leads to a vertex from the vertices
+ * @brief Read the path that leads to a vertex from the edges recorded by a search
  * Runs in O(V) time where V is the number of vertices in the graph because the path's length is at most V-1.
- * 
+ *
  * @tparam T template parameter related to the type of vertice
- * @param destNode Last vertice on the path
+ * @param g graph where the search was performed
+ * @param labels labels of the search, holding the edge used to reach each slot
+ * @param destNode slot of the last vertice on the path
  * @param orderedIds initialized list where the ids of the vertices on the path will be put
  */
-template <class T> 
-void getDrivingPath(Vertex<T>* destNode, std::list<T>& orderedIds) {
-    if (destNode == nullptr) {
+template <class T>
+void getDrivingPath(const CsrGraph<T>& g, const SearchLabels& labels, int destNode, std::list<T>& orderedIds) {
+    if (destNode == -1) {
         orderedIds = {};
         return;
     }
-    orderedIds.push_front(destNode->getId());
-    Edge<T>* aux_edge = destNode->getPath();
-    while (aux_edge != nullptr) {
-        orderedIds.push_front(aux_edge->getOrig()->getId());
-        aux_edge = aux_edge->getOrig()->getPath();
+    orderedIds.push_front(g.getId(destNode));
+    int aux_edge = labels.getPath(destNode);
+    while (aux_edge != -1) {
+        orderedIds.push_front(g.getId(g.getEdgeOrig(aux_edge)));
+        aux_edge = labels.getPath(g.getEdgeOrig(aux_edge));
     }
-}
\ No newline at end of file
+}
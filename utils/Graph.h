@@ -10,6 +10,7 @@
 #include <limits>
 #include <algorithm>
 #include <string>
+#include <unordered_map>
 #include "MutablePriorityQueue.h"
 
 template <class T>
@@ -17,6 +18,11 @@ class Edge;
 
 #define INF std::numeric_limits<double>::max()const T &in
 
+/*
+ * Largest vertex id. Ids index dense tables (here and in CsrGraph), so the bound keeps each one under 64 MB.
+ */
+const int maxVertexId = (1 << 24) - 1;
+
 /************************* Vertex  **************************/
 
 template <class T>
@@ -52,6 +58,10 @@ public:
     void setPath(Edge<T> *path);
     void setWalkingPath(Edge<T> *path);
     Edge<T> * addEdge(Vertex<T> *dest, int driving, int walking);
+    /*
+     * Reserves room for count outgoing and count incoming edges.
+     */
+    void reserveEdges(unsigned int count);
     bool removeEdge(T in);
     void removeOutgoingEdges();
     friend class MutablePriorityQueue<Vertex>;
@@ -118,18 +128,18 @@ protected:
 template <class T>
 class Graph {
 public:
-    ~Graph();
     /*
     * Auxiliary function to find a vertex with a given the content.
     */
     Vertex<T> *findVertex(std::string code) const;
     /**
-     * @brief Find a vertex by its id
+     * @brief Find a vertex by its id. Ids are integers from 0 to maxVertexId.
      */
     Vertex<T> *findVertexById(T id) const;
     /*
      *  Adds a vertex with a given content or id (in) to a graph (this).
-     *  Returns true if successful, and false if a vertex with that content already exists.
+     *  Returns true if successful, and false if a vertex with that content already exists
+     *  or its id is outside 0..maxVertexId.
      */
     bool addVertex(std::string location, const T &id, std::string code, bool parking);
     bool removeVertex(const T &in);
@@ -142,6 +152,12 @@ public:
     bool addEdge(std::string &sourc, std::string &dest, int driving, int walking);
     bool removeEdge(const T &source, const T &dest);
     bool addBidirectionalEdge(const std::string &sourc, const std::string &dest, int drivingTime, int walkingTime);
+    bool addBidirectionalEdge(Vertex<T> *v1, Vertex<T> *v2, int drivingTime, int walkingTime);
+
+    /*
+     * Reserves room for count vertices, so that loading them does not reallocate the vertex set or its indexes.
+     */
+    void reserveVertices(int count);
 
     int getNumVertex() const;
 
@@ -154,22 +170,27 @@ public:
 
 protected:
     std::vector<Vertex<T> *> vertexSet;    // vertex set
-
-    double ** distMatrix = nullptr;   // dist matrix for Floyd-Warshall
-    int **pathMatrix = nullptr;   // path matrix for Floyd-Warshall
+    std::unordered_map<std::string, int> codeIndex; // index in vertexSet of each code
+    std::vector<int> idIndex;   // index in vertexSet of each id, -1 if unused
 
     /*
      * Finds the index of the vertex with a given content.
      */
     int findVertexIdx(const T &in) const;
+    /*
+     * Adds the vertex at a given index of vertexSet to codeIndex and idIndex.
+     */
+    void indexVertex(int idx);
+    /*
+     * Rebuilds codeIndex and idIndex after vertexSet is reordered.
+     */
+    void rebuildIndexes();
     /**
     * Auxiliary function to set the "path" field to make a spanning tree.
     */
 
 };
 
-void deleteMatrix(int **m, int n);
-void deleteMatrix(double **m, int n);
 
 
 /************************* Vertex  **************************/
@@ -189,6 +210,12 @@ Edge<T> * Vertex<T>::addEdge(Vertex<T> *d, int driving, int walking) {
     return newEdge;
 }
 
+template <class T>
+void Vertex<T>::reserveEdges(unsigned int count) {
+    adj.reserve(count);
+    incoming.reserve(count);
+}
+
 /*
  * Auxiliary function to remove an outgoing edge (with a given destination (d))
  * from a vertex (this).
@@ -430,25 +457,25 @@ std::vector<Vertex<T> *> Graph<T>::getVertexSet() const {
 }
 
 /*
- * Auxiliary function to find a vertex with a given code.
+ * Auxiliary function to find a vertex with a given code, in O(1) average time.
  */
 template <class T>
 Vertex<T> * Graph<T>::findVertex(std::string code) const {
-    for (auto v : vertexSet)
-        if (v->getCode() == code)
-            return v;
-    return nullptr;
+    auto it = codeIndex.find(code);
+    if (it == codeIndex.end())
+        return nullptr;
+    return vertexSet[it->second];
 }
 
 /*
- * Auxiliary function to find a vertex with a given id.
+ * Auxiliary function to find a vertex with a given id, in O(1) time.
  */
 template <class T>
 Vertex<T> * Graph<T>::findVertexById(T id) const {
-    for (auto v : vertexSet)
-        if (v->getId() == id)
-            return v;
-    return nullptr;
+    int idx = findVertexIdx(id);
+    if (idx == -1)
+        return nullptr;
+    return vertexSet[idx];
 }
 
 /*
@@ -456,20 +483,47 @@ Vertex<T> * Graph<T>::findVertexById(T id) const {
  */
 template <class T>
 int Graph<T>::findVertexIdx(const T &in) const {
+    if (in < 0 || static_cast<std::size_t>(in) >= idIndex.size())
+        return -1;
+    return idIndex[in];
+}
+
+template <class T>
+void Graph<T>::indexVertex(int idx) {
+    Vertex<T> *v = vertexSet[idx];
+    codeIndex.insert({v->getCode(), idx});
+    T id = v->getId();
+    if (id < 0)
+        return;
+    if (static_cast<std::size_t>(id) >= idIndex.size())
+        idIndex.resize(id + 1, -1);
+    if (idIndex[id] == -1)
+        idIndex[id] = idx;
+}
+
+template <class T>
+void Graph<T>::rebuildIndexes() {
+    codeIndex.clear();
+    idIndex.clear();
     for (unsigned i = 0; i < vertexSet.size(); i++)
-        if (vertexSet[i]->getId() == in)
-            return i;
-    return -1;
+        indexVertex(i);
 }
 /*
  *  Adds a vertex with a given content or id (in) to a graph (this).
  *  Returns true if successful, and false if a vertex with that content already exists.
  */
+template <class T>
+void Graph<T>::reserveVertices(int count) {
+    vertexSet.reserve(count);
+    codeIndex.reserve(count);
+}
+
 template <class T>
 bool Graph<T>::addVertex(std::string location, const T &id, std::string code, bool parking) {
-    if (findVertex(code) != nullptr)
+    if (id < 0 || id > maxVertexId || findVertex(code) != nullptr)
         return false;
     vertexSet.push_back(new Vertex<T>(location, id, code, parking));
+    indexVertex(vertexSet.size() - 1);
     return true;
 }
 
@@ -480,19 +534,18 @@ bool Graph<T>::addVertex(std::string location, const T &id, std::string code, bo
  */
 template <class T>
 bool Graph<T>::removeVertex(const T &in) {
-    for (auto it = vertexSet.begin(); it != vertexSet.end(); it++) {
-        if ((*it)->getId() == in) {
-            auto v = *it;
-            v->removeOutgoingEdges();
-            for (auto u : vertexSet) {
-                u->removeEdge(v->getId());
-            }
-            vertexSet.erase(it);
-            delete v;
-            return true;
-        }
+    int idx = findVertexIdx(in);
+    if (idx == -1)
+        return false;
+    auto v = vertexSet[idx];
+    v->removeOutgoingEdges();
+    for (auto u : vertexSet) {
+        u->removeEdge(v->getId());
     }
-    return false;
+    vertexSet.erase(vertexSet.begin() + idx);
+    delete v;
+    rebuildIndexes();
+    return true;
 }
 
 /*
@@ -517,7 +570,7 @@ bool Graph<T>::addEdge(std::string &sourc, std::string &dest, int driving, int w
  */
 template <class T>
 bool Graph<T>::removeEdge(const T &sourc, const T &dest) {
-    Vertex<T> * srcVertex = findVertex(sourc);
+    Vertex<T> * srcVertex = findVertexById(sourc);
     if (srcVertex == nullptr) {
         return false;
     }
@@ -526,8 +579,11 @@ bool Graph<T>::removeEdge(const T &sourc, const T &dest) {
 
 template <class T>
 bool Graph<T>::addBidirectionalEdge(const std::string &sourc, const std::string &dest, int drivingTime, int walkingTime) {
-    auto v1 = findVertex(sourc);
-    auto v2 = findVertex(dest);
+    return addBidirectionalEdge(findVertex(sourc), findVertex(dest), drivingTime, walkingTime);
+}
+
+template <class T>
+bool Graph<T>::addBidirectionalEdge(Vertex<T> *v1, Vertex<T> *v2, int drivingTime, int walkingTime) {
     if (v1 == nullptr || v2 == nullptr)
         return false;
     auto e1 = v1->addEdge(v2, drivingTime, walkingTime);
@@ -567,30 +623,6 @@ void Graph<T>::printEdges() const {
     }
 }
 
-inline void deleteMatrix(int **m, int n) {
-    if (m != nullptr) {
-        for (int i = 0; i < n; i++)
-            if (m[i] != nullptr)
-                delete [] m[i];
-        delete [] m;
-    }
-}
-
-inline void deleteMatrix(double **m, int n) {
-    if (m != nullptr) {
-        for (int i = 0; i < n; i++)
-            if (m[i] != nullptr)
-                delete [] m[i];
-        delete [] m;
-    }
-}
-
-template <class T>
-Graph<T>::~Graph() {
-    deleteMatrix(distMatrix, vertexSet.size());
-    deleteMatrix(pathMatrix, vertexSet.size());
-}
-
 /**
  * @brief Cleans the visited and dist fields of vertices
  * 
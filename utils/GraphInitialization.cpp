@@ -1,84 +1,176 @@
 #pragma once
 
 #include <iostream>
-#include <fstream>
-#include <sstream>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 #include "Graph.h"
+#include "MappedFile.h"
 #include <limits>
 
 
+/**
+ * @brief Reads the next line of a CSV buffer, without its terminator ("\n" or "\r\n").
+ *
+ * @param pos position where the line starts, moved to the start of the next line
+ * @param end end of the buffer
+ * @param line used to return the line
+ * @return true if a line was read, false at the end of the buffer
+ */
+inline bool nextCsvLine(const char *&pos, const char *end, std::string_view &line) {
+    if (pos >= end)
+        return false;
+    const char *newline = static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+    const char *lineEnd = newline == nullptr ? end : newline;
+    line = std::string_view(pos, lineEnd - pos);
+    if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+    pos = newline == nullptr ? end : newline + 1;
+    return true;
+}
+
+/**
+ * @brief Parses a whole field as a non-negative integer.
+ */
+inline bool parseCsvInt(std::string_view field, int &value) {
+    if (field.empty() || field.front() == '-' || field.front() == '+')
+        return false;
+    auto result = std::from_chars(field.data(), field.data() + field.size(), value);
+    return result.ec == std::errc() && result.ptr == field.data() + field.size();
+}
+
 /**
  * @brief Reads location data from a CSV file and adds it to the graph.
  * Works in O(V) where V is the number of vertices.
- * 
- * Extracts location name, ID, code, and parking availability from 
- * `datasets/locations.csv` and adds vertices to the graph.
- * 
+ *
+ * Extracts location name, ID, code, and parking availability (0 or 1) from each row and adds vertices to the graph.
+ * The file is mapped in memory and tokenized in place, and the vertex set is sized from a first pass over the lines.
+ * The location name is everything before the last three fields, so it may contain commas.
+ * Malformed rows, rows whose id is above maxVertexId and rows with a repeated code are reported with their line number
+ * and skipped.
+ *
  * @param g Reference to the Graph object.
+ * @param path Path of the CSV file.
+ * @return int Number of rows skipped, or -1 if the file can't be read.
  */
-void readParseLocations(Graph<int> &g) {
-    std::ifstream file("datasets/locations.csv");
-    if (!file.is_open()) {
-        std::cout << "Error opening file!\n";
+int readParseLocations(Graph<int> &g, const std::string &path = "datasets/locations.csv") {
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        std::cout << "Error opening file " << path << "!\n";
+        return -1;
     }
-    
-    std::string line;
-    std::getline(file, line);
-    
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string location;
+    const char *pos = file.data(), *end = file.data() + file.size();
+    g.reserveVertices(std::count(pos, end, '\n') + 1);
+
+    std::string_view line;
+    nextCsvLine(pos, end, line); // header
+    int lineNumber = 1, skipped = 0;
+    while (nextCsvLine(pos, end, line)) {
+        lineNumber++;
+        if (line.empty())
+            continue;
+        size_t c3 = line.rfind(',');
+        size_t c2 = c3 == std::string_view::npos || c3 == 0 ? std::string_view::npos : line.rfind(',', c3 - 1);
+        size_t c1 = c2 == std::string_view::npos || c2 == 0 ? std::string_view::npos : line.rfind(',', c2 - 1);
         int id;
-        std::string code;
-        bool parking;
-        
-        std::getline(ss, location, ',');
-        ss >> id;
-        ss.ignore(); 
-        std::getline(ss, code, ',');
-        ss >> parking;
-        g.addVertex(location, id, code, parking);
+        std::string_view code, parking;
+        if (c1 != std::string_view::npos) {
+            code = line.substr(c2 + 1, c3 - c2 - 1);
+            parking = line.substr(c3 + 1);
+        }
+        if (c1 == std::string_view::npos || !parseCsvInt(line.substr(c1 + 1, c2 - c1 - 1), id) || code.empty() || (parking != "0" && parking != "1")) {
+            std::cout << path << ":" << lineNumber << ": malformed location row, expected Location,Id,Code,Parking\n";
+            skipped++;
+            continue;
+        }
+        if (id > maxVertexId) {
+            std::cout << path << ":" << lineNumber << ": location id " << id << " out of range, expected 0 to " << maxVertexId << "\n";
+            skipped++;
+            continue;
+        }
+        if (!g.addVertex(std::string(line.substr(0, c1)), id, std::string(code), parking == "1")) {
+            std::cout << path << ":" << lineNumber << ": repeated location code " << code << "\n";
+            skipped++;
+        }
     }
+    return skipped;
 }
 
 
 /**
  * @brief Reads distance data from a CSV file and adds edges to the graph.
  * Works in O(E) where E is the number of edges.
- * 
- * Extracts locations, driving time, and walking time from `datasets/distances.csv` 
- * and adds bidirectional edges to the graph. 
- * 
+ *
+ * Extracts locations, driving time ("X" if the segment can't be driven), and walking time from each row
+ * and adds bidirectional edges to the graph. A first pass tokenizes every row in place and counts the edges of
+ * each vertex, so that the adjacency lists are allocated once before the edges are added.
+ * Malformed rows and rows naming unknown locations are reported with their line number and skipped.
+ *
  * @param g Reference to the Graph object.
+ * @param path Path of the CSV file.
+ * @return int Number of rows skipped, or -1 if the file can't be read.
  */
-void readParseDistances(Graph<int> &g) {
-    std::ifstream file("datasets/distances.csv");
-    if (!file.is_open()) {
-        std::cout << "Error opening file!\n";
+int readParseDistances(Graph<int> &g, const std::string &path = "datasets/distances.csv") {
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        std::cout << "Error opening file " << path << "!\n";
+        return -1;
     }
-    
-    std::string line;
-    std::getline(file, line);
-    
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string location1;
-        std::string location2;
-        std::string driving_str;
-        int walking;
-        
-        std::getline(ss, location1, ',');
-        std::getline(ss, location2, ',');
-        std::getline(ss, driving_str, ',');
-        ss >> walking;
+    struct Row {
+        Vertex<int> *v1, *v2;
+        int driving, walking;
+    };
+    const char *pos = file.data(), *end = file.data() + file.size();
+    std::vector<Row> rows;
+    rows.reserve(std::count(pos, end, '\n') + 1);
+    std::unordered_map<Vertex<int> *, unsigned int> degree;
 
-        int driving;
-        if (driving_str == "X") {
-            driving = std::numeric_limits<int>::max();  
-        } else {
-            std::stringstream(driving_str) >> driving;
+    std::string_view line;
+    nextCsvLine(pos, end, line); // header
+    int lineNumber = 1, skipped = 0;
+    while (nextCsvLine(pos, end, line)) {
+        lineNumber++;
+        if (line.empty())
+            continue;
+        std::string_view fields[4];
+        int count = 0;
+        for (size_t start = 0;; count++) {
+            size_t comma = line.find(',', start);
+            if (count < 4)
+                fields[count] = line.substr(start, comma - start);
+            if (comma == std::string_view::npos)
+                break;
+            start = comma + 1;
         }
-        g.addBidirectionalEdge(location1, location2, driving, walking);
+        count++;
+        Row row;
+        bool drivable = fields[2] != "X";
+        if (count != 4 || (drivable && !parseCsvInt(fields[2], row.driving)) || !parseCsvInt(fields[3], row.walking)) {
+            std::cout << path << ":" << lineNumber << ": malformed distance row, expected Location1,Location2,Driving,Walking\n";
+            skipped++;
+            continue;
+        }
+        if (!drivable)
+            row.driving = std::numeric_limits<int>::max();
+        row.v1 = g.findVertex(std::string(fields[0]));
+        row.v2 = g.findVertex(std::string(fields[1]));
+        if (row.v1 == nullptr || row.v2 == nullptr) {
+            std::cout << path << ":" << lineNumber << ": unknown location code " << (row.v1 == nullptr ? fields[0] : fields[1]) << "\n";
+            skipped++;
+            continue;
+        }
+        degree[row.v1]++;
+        degree[row.v2]++;
+        rows.push_back(row);
     }
-}
\ No newline at end of file
+
+    for (auto &entry : degree)
+        entry.first->reserveEdges(entry.second);
+    for (const Row &row : rows)
+        g.addBidirectionalEdge(row.v1, row.v2, row.driving, row.walking);
+    return skipped;
+}
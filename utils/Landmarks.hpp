@@ -0,0 +1,224 @@
+#pragma once
+
+#include "../utils/CsrGraph.hpp"
+#include "../utils/SlotPriorityQueue.h"
+#include "../utils/SearchContext.hpp"
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Computes the driving or walking distance from (or, over incoming edges, to) a root slot to every vertex,
+ * with INT_MAX for unreachable vertices. Time complexity is O((V+E)logV).
+ *
+ * @tparam T
+ * @param g graph
+ * @param labels labels used by the search
+ * @param root slot where the search starts
+ * @param reverse if true, distances are measured from every vertex to root
+ * @param walking if true, walking times are used instead of driving times
+ * @param dist used to return the distance of each slot
+ */
+template <class T>
+void landmarkDistances(const CsrGraph<T>& g, SearchLabels& labels, int root, bool reverse, bool walking, std::vector<int>& dist) {
+    labels.reset(g.getNumVertex());
+    labels.setDist(root, 0);
+    SlotPriorityQueue pq(labels.getDistArray(), labels.getQueueIndexArray());
+    pq.insert(root);
+    while (!pq.empty()) {
+        int v = pq.extractMin();
+        labels.setProcessing(v, false);
+        labels.setVisited(v, true);
+        int begin = reverse ? g.inBegin(v) : g.outBegin(v);
+        int end = reverse ? g.inEnd(v) : g.outEnd(v);
+        for (int i = begin; i < end; i++) {
+            int u = reverse ? g.getInOrig(i) : g.getEdgeDest(i);
+            int w = reverse ? (walking ? g.getInWalkingTime(i) : g.getInDrivingTime(i)) : (walking ? g.getWalkingTime(i) : g.getDrivingTime(i));
+            if (w == std::numeric_limits<int>::max() || (labels.isVisited(u) && !labels.isProcessing(u))) {
+                continue;
+            }
+            if (labels.getDist(u) > labels.getDist(v) + w) {
+                labels.setDist(u, labels.getDist(v) + w);
+                if (!labels.isVisited(u)) {
+                    pq.insert(u);
+                    labels.setVisited(u, true);
+                    labels.setProcessing(u, true);
+                } else {
+                    pq.decreaseKey(u);
+                }
+            }
+        }
+    }
+    dist.resize(g.getNumVertex());
+    for (int v = 0; v < g.getNumVertex(); v++) {
+        dist[v] = labels.getDist(v);
+    }
+}
+
+/************************* Landmarks  **************************/
+
+/**
+ * @brief ALT preprocessing: K landmarks and their driving and walking distance tables, from each landmark to every vertex
+ * and from every vertex to each landmark. By the triangle inequality, d(v,t) >= d(L,t) - d(L,v) and d(v,t) >= d(v,L) - d(t,L),
+ * which gives lower bounds for goal-directed (A*) searches. Restrictions only remove vertices and edges, so the bounds
+ * remain admissible under any avoid_nodes/avoid_edges.
+ *
+ * Landmarks are picked by farthest selection: each new landmark is the vertex farthest (by driving time) from those
+ * already picked. Tables take 4*K*V integers, stored vertex-major so that all landmarks of a vertex are contiguous.
+ *
+ * @tparam T type of the vertex ids
+ */
+template <class T>
+class Landmarks {
+public:
+    Landmarks() = default;
+    /**
+     * @brief Picks numLandmarks landmarks and computes their tables in O(K(V+E)logV).
+     */
+    Landmarks(const CsrGraph<T> &g, int numLandmarks);
+
+    int getNumLandmarks() const;
+    int getLandmark(int i) const;
+
+    /*
+     * Distances between landmark i and slot v, INT_MAX if unreachable.
+     */
+    int getDistFrom(int v, int i, bool walking) const;
+    int getDistTo(int v, int i, bool walking) const;
+
+protected:
+    std::vector<int> landmarks;
+    std::vector<int> drivingFrom;   // [v * K + i] = d(landmark i, v)
+    std::vector<int> drivingTo;     // [v * K + i] = d(v, landmark i)
+    std::vector<int> walkingFrom;
+    std::vector<int> walkingTo;
+};
+
+template <class T>
+Landmarks<T>::Landmarks(const CsrGraph<T> &g, int numLandmarks) {
+    int n = g.getNumVertex();
+    if (n == 0 || numLandmarks <= 0)
+        return;
+    if (numLandmarks > n)
+        numLandmarks = n;
+    SearchLabels labels;
+    std::vector<int> dist;
+    // closest distance from the picked landmarks to each vertex, unreachable vertices count as farthest
+    std::vector<long long> closest(n, std::numeric_limits<long long>::max());
+    std::vector<std::vector<int>> tables[4];
+    int next = 0;
+    landmarkDistances(g, labels, 0, false, false, dist);
+    for (int v = 0; v < n; v++)
+        if (dist[v] != std::numeric_limits<int>::max() && dist[v] > dist[next])
+            next = v;
+    while ((int) landmarks.size() < numLandmarks) {
+        landmarks.push_back(next);
+        closest[next] = -1;
+        for (int k = 0; k < 4; k++) {
+            tables[k].emplace_back();
+            landmarkDistances(g, labels, next, k % 2 == 1, k >= 2, tables[k].back());
+        }
+        const std::vector<int> &from = tables[0].back();
+        next = -1;
+        for (int v = 0; v < n; v++) {
+            if (closest[v] == -1)
+                continue;
+            if (from[v] != std::numeric_limits<int>::max() && from[v] < closest[v])
+                closest[v] = from[v];
+            if (next == -1 || closest[v] > closest[next])
+                next = v;
+        }
+        if (next == -1)
+            break;
+    }
+    int k = landmarks.size();
+    std::vector<int> *flat[4] = {&drivingFrom, &drivingTo, &walkingFrom, &walkingTo};
+    for (int t = 0; t < 4; t++) {
+        flat[t]->resize((size_t) n * k);
+        for (int i = 0; i < k; i++)
+            for (int v = 0; v < n; v++)
+                (*flat[t])[(size_t) v * k + i] = tables[t][i][v];
+    }
+}
+
+template <class T>
+int Landmarks<T>::getNumLandmarks() const {
+    return landmarks.size();
+}
+
+template <class T>
+int Landmarks<T>::getLandmark(int i) const {
+    return landmarks[i];
+}
+
+template <class T>
+int Landmarks<T>::getDistFrom(int v, int i, bool walking) const {
+    return (walking ? walkingFrom : drivingFrom)[(size_t) v * landmarks.size() + i];
+}
+
+template <class T>
+int Landmarks<T>::getDistTo(int v, int i, bool walking) const {
+    return (walking ? walkingTo : drivingTo)[(size_t) v * landmarks.size() + i];
+}
+
+/************************* LandmarkPotential  **************************/
+
+/**
+ * @brief Lower bound on the cost of reaching a set of targets, each with an extra cost added on arrival
+ * (for a single destination, one target with offset 0). For each landmark L it uses
+ * min_c(d(L,c) + offset(c)) - d(L,v) and d(v,L) - max_c(d(c,L) - offset(c)), which is consistent, so A* with it
+ * settles every vertex once. A landmark direction is only used when every target is reachable in it.
+ *
+ * get returns -1 for vertices that provably can't reach any target, which the searches prune.
+ *
+ * @tparam T type of the vertex ids
+ */
+template <class T>
+class LandmarkPotential {
+public:
+    LandmarkPotential(const Landmarks<T> &landmarks, const std::unordered_map<int, int> &targets, bool walking);
+    int get(int v) const;
+
+protected:
+    const Landmarks<T> &landmarks;
+    bool walking;
+    std::vector<long long> fromBound;   // min over targets of d(L,c) + offset, or LLONG_MAX if unusable
+    std::vector<long long> toBound;     // max over targets of d(c,L) - offset, or LLONG_MIN if unusable
+};
+
+template <class T>
+LandmarkPotential<T>::LandmarkPotential(const Landmarks<T> &landmarks, const std::unordered_map<int, int> &targets, bool walking): landmarks(landmarks), walking(walking) {
+    int k = landmarks.getNumLandmarks();
+    fromBound.assign(k, std::numeric_limits<long long>::max());
+    toBound.assign(k, std::numeric_limits<long long>::min());
+    for (int i = 0; i < k; i++) {
+        long long from = std::numeric_limits<long long>::max(), to = std::numeric_limits<long long>::min();
+        bool fromUsable = !targets.empty(), toUsable = !targets.empty();
+        for (auto &target : targets) {
+            int df = landmarks.getDistFrom(target.first, i, walking);
+            int dt = landmarks.getDistTo(target.first, i, walking);
+            if (df == std::numeric_limits<int>::max()) fromUsable = false;
+            else from = std::min(from, (long long) df + target.second);
+            if (dt == std::numeric_limits<int>::max()) toUsable = false;
+            else to = std::max(to, (long long) dt - target.second);
+        }
+        if (fromUsable) fromBound[i] = from;
+        if (toUsable) toBound[i] = to;
+    }
+}
+
+template <class T>
+int LandmarkPotential<T>::get(int v) const {
+    long long h = 0;
+    for (int i = 0; i < landmarks.getNumLandmarks(); i++) {
+        int df = landmarks.getDistFrom(v, i, walking);
+        int dt = landmarks.getDistTo(v, i, walking);
+        if (fromBound[i] != std::numeric_limits<long long>::max() && df != std::numeric_limits<int>::max())
+            h = std::max(h, fromBound[i] - df);
+        if (toBound[i] != std::numeric_limits<long long>::min()) {
+            if (dt == std::numeric_limits<int>::max())
+                return -1; // every target reaches L but v does not, so v can't reach any target
+            h = std::max(h, dt - toBound[i]);
+        }
+    }
+    return h;
+}
@@ -0,0 +1,126 @@
+/*
+ * MappedFile.h
+ * Read-only view of a whole file. On POSIX systems the file is memory-mapped, so pages are only
+ * read when touched and nothing is copied; elsewhere it is read in large blocks into a buffer.
+ */
+
+#ifndef DA_TP_CLASSES_MAPPEDFILE
+#define DA_TP_CLASSES_MAPPEDFILE
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define DA_TP_CLASSES_MAPPEDFILE_MMAP
+#endif
+
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string &path);
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+
+    /*
+     * Maps the file at path, releasing the previous one. Returns false if it can't be read.
+     */
+    bool open(const std::string &path);
+    void close();
+
+    bool isOpen() const;
+    const char *data() const;
+    std::size_t size() const;
+
+private:
+    const char *begin = nullptr;
+    std::size_t length = 0;
+    bool opened = false;
+    bool mapped = false;        // begin points to a mapping, not to buffer
+    std::vector<char> buffer;
+};
+
+inline MappedFile::MappedFile(const std::string &path) {
+    open(path);
+}
+
+inline MappedFile::~MappedFile() {
+    close();
+}
+
+inline bool MappedFile::open(const std::string &path) {
+    close();
+#ifdef DA_TP_CLASSES_MAPPEDFILE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) == -1) {
+        ::close(fd);
+        return false;
+    }
+    length = info.st_size;
+    if (length > 0) {
+        void *address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            madvise(address, length, MADV_SEQUENTIAL);
+            begin = static_cast<const char *>(address);
+            mapped = true;
+        }
+    }
+    ::close(fd);
+    if (mapped || length == 0) {
+        opened = true;
+        return true;
+    }
+    length = 0;
+#endif
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+    const std::size_t block = 1 << 20;
+    std::size_t used = 0;
+    while (file) {
+        buffer.resize(used + block);
+        file.read(buffer.data() + used, block);
+        used += file.gcount();
+    }
+    buffer.resize(used);
+    begin = buffer.data();
+    length = used;
+    opened = true;
+    return true;
+}
+
+inline void MappedFile::close() {
+#ifdef DA_TP_CLASSES_MAPPEDFILE_MMAP
+    if (mapped)
+        munmap(const_cast<char *>(begin), length);
+#endif
+    begin = nullptr;
+    length = 0;
+    opened = false;
+    mapped = false;
+    buffer.clear();
+    buffer.shrink_to_fit();
+}
+
+inline bool MappedFile::isOpen() const {
+    return opened;
+}
+
+inline const char *MappedFile::data() const {
+    return begin;
+}
+
+inline std::size_t MappedFile::size() const {
+    return length;
+}
+
+#endif /* DA_TP_CLASSES_MAPPEDFILE */
@@ -0,0 +1,108 @@
+/*
+ * MinPlus.h
+ * Min-plus row kernel used by the all-pairs tables: c[j] = min(c[j], a + b[j]), recording the next hop of every improved
+ * entry. Weights are non-negative ints and INT_MAX means unreachable; sums saturate to INT_MAX instead of wrapping.
+ * AVX2 and SSE4.1 versions are chosen at runtime when the CPU supports them, with a portable scalar fallback.
+ */
+
+#ifndef DA_TP_CLASSES_MINPLUS
+#define DA_TP_CLASSES_MINPLUS
+
+#include <climits>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define DA_TP_CLASSES_MINPLUS_X86
+#endif
+
+/*
+ * Relaxes count entries: wherever a + b[j] < c[j], sets c[j] = a + b[j] and next[j] = hop.
+ * a must be finite; b[j] and c[j] may be INT_MAX. Ties keep the current entry.
+ */
+typedef void (*MinPlusRowKernel)(int a, int hop, const int *b, int *c, int *next, int count);
+
+inline void minPlusRowScalar(int a, int hop, const int *b, int *c, int *next, int count) {
+    for (int j = 0; j < count; j++) {
+        // b[j] <= INT_MAX - a is the saturation test, so INT_MAX never takes part in a sum
+        if (b[j] <= INT_MAX - a && a + b[j] < c[j]) {
+            c[j] = a + b[j];
+            next[j] = hop;
+        }
+    }
+}
+
+#ifdef DA_TP_CLASSES_MINPLUS_X86
+
+/*
+ * a and b[j] are non-negative, so a sum that doesn't fit wraps to a negative value; those lanes are set to INT_MAX.
+ */
+__attribute__((target("sse4.1")))
+inline void minPlusRowSse41(int a, int hop, const int *b, int *c, int *next, int count) {
+    const __m128i va = _mm_set1_epi32(a), vhop = _mm_set1_epi32(hop), inf = _mm_set1_epi32(INT_MAX);
+    const __m128i zero = _mm_setzero_si128();
+    int j = 0;
+    for (; j + 4 <= count; j += 4) {
+        __m128i sum = _mm_add_epi32(va, _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + j)));
+        sum = _mm_blendv_epi8(sum, inf, _mm_cmplt_epi32(sum, zero));
+        __m128i vc = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c + j));
+        __m128i better = _mm_cmpgt_epi32(vc, sum);
+        if (_mm_testz_si128(better, better))
+            continue;
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(c + j), _mm_min_epi32(vc, sum));
+        __m128i vn = _mm_loadu_si128(reinterpret_cast<const __m128i *>(next + j));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(next + j), _mm_blendv_epi8(vn, vhop, better));
+    }
+    minPlusRowScalar(a, hop, b + j, c + j, next + j, count - j);
+}
+
+__attribute__((target("avx2")))
+inline void minPlusRowAvx2(int a, int hop, const int *b, int *c, int *next, int count) {
+    const __m256i va = _mm256_set1_epi32(a), vhop = _mm256_set1_epi32(hop), inf = _mm256_set1_epi32(INT_MAX);
+    const __m256i zero = _mm256_setzero_si256();
+    int j = 0;
+    for (; j + 8 <= count; j += 8) {
+        __m256i sum = _mm256_add_epi32(va, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + j)));
+        sum = _mm256_blendv_epi8(sum, inf, _mm256_cmpgt_epi32(zero, sum));
+        __m256i vc = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(c + j));
+        __m256i better = _mm256_cmpgt_epi32(vc, sum);
+        if (_mm256_testz_si256(better, better))
+            continue;
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(c + j), _mm256_min_epi32(vc, sum));
+        __m256i vn = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(next + j));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(next + j), _mm256_blendv_epi8(vn, vhop, better));
+    }
+    minPlusRowScalar(a, hop, b + j, c + j, next + j, count - j);
+}
+
+#endif
+
+/*
+ * Name of the kernel picked for this CPU: "avx2", "sse4.1" or "scalar".
+ */
+inline const char *getMinPlusKernelName() {
+#ifdef DA_TP_CLASSES_MINPLUS_X86
+    if (__builtin_cpu_supports("avx2"))
+        return "avx2";
+    if (__builtin_cpu_supports("sse4.1"))
+        return "sse4.1";
+#endif
+    return "scalar";
+}
+
+/*
+ * Fastest kernel this CPU supports, checked once.
+ */
+inline MinPlusRowKernel getMinPlusRowKernel() {
+    static const MinPlusRowKernel kernel = [] {
+#ifdef DA_TP_CLASSES_MINPLUS_X86
+        if (__builtin_cpu_supports("avx2"))
+            return static_cast<MinPlusRowKernel>(minPlusRowAvx2);
+        if (__builtin_cpu_supports("sse4.1"))
+            return static_cast<MinPlusRowKernel>(minPlusRowSse41);
+#endif
+        return static_cast<MinPlusRowKernel>(minPlusRowScalar);
+    }();
+    return kernel;
+}
+
+#endif /* DA_TP_CLASSES_MINPLUS */
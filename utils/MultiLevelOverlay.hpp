@@ -0,0 +1,613 @@
+#pragma once
+
+#include "../utils/CsrGraph.hpp"
+#include "../utils/SlotPriorityQueue.h"
+#include "../utils/SearchContext.hpp"
+#include "../utils/PairHash.hpp"
+#include <algorithm>
+#include <limits>
+#include <list>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/************************* OverlayMetric  **************************/
+
+/**
+ * @brief Clique weights of every cell of a MultiLevelOverlay. A metric customized for a restriction shares the weights
+ * of the unaffected cells with the base metric and only owns those of the cells it recomputed, so the base metric
+ * must outlive it. Cells whose clique is no longer valid and was not recomputed are marked open, and queries search
+ * inside them instead. Moving keeps the weights in place; copying is not allowed.
+ */
+class OverlayMetric {
+public:
+    OverlayMetric() = default;
+    OverlayMetric(const OverlayMetric &) = delete;
+    OverlayMetric &operator=(const OverlayMetric &) = delete;
+    OverlayMetric(OverlayMetric &&) = default;
+    OverlayMetric &operator=(OverlayMetric &&) = default;
+
+    /*
+     * Row-major |B|x|B| matrix of the cell, where B are its boundary vertices; INT_MAX if there is no path inside the cell.
+     */
+    const int *getWeights(int cell) const;
+    void setWeights(int cell, std::vector<int> weights);
+
+    bool isOpen(int cell) const;
+    void setOpen(int cell);
+
+    /*
+     * Sizes the metric for numCells cells, with no weights yet.
+     */
+    void resize(int numCells);
+
+    /*
+     * Makes every cell use the weights of base.
+     */
+    void share(const OverlayMetric &base);
+
+protected:
+    std::vector<const int *> cellWeights;
+    std::vector<std::vector<int>> owned;    // weights computed for this metric
+    std::vector<char> open;
+};
+
+inline const int *OverlayMetric::getWeights(int cell) const {
+    return cellWeights[cell];
+}
+
+inline void OverlayMetric::setWeights(int cell, std::vector<int> weights) {
+    owned.push_back(std::move(weights));
+    cellWeights[cell] = owned.back().data();
+}
+
+inline bool OverlayMetric::isOpen(int cell) const {
+    return open[cell];
+}
+
+inline void OverlayMetric::setOpen(int cell) {
+    open[cell] = true;
+}
+
+inline void OverlayMetric::resize(int numCells) {
+    cellWeights.assign(numCells, nullptr);
+    owned.clear();
+    open.assign(numCells, false);
+}
+
+inline void OverlayMetric::share(const OverlayMetric &base) {
+    cellWeights = base.cellWeights;
+    owned.clear();
+    open.assign(cellWeights.size(), false);
+}
+
+/************************* MultiLevelOverlay  **************************/
+
+/**
+ * @brief Customizable route planning over the driving times of a CsrGraph.
+ *
+ * The vertices are split by recursive BFS bisection (metric-independent, edges taken as undirected) into nested cells:
+ * level 1 cells hold about leafSize vertices and each level groups 2^bitsPerLevel cells of the level below. A vertex
+ * is a boundary vertex of its level-l cell if an edge links it to another level-l cell. Customization gives each cell
+ * a clique of the shortest paths inside it between its boundary vertices, level 1 from the original edges and every other
+ * level from the cliques of the level below.
+ *
+ * A restriction (avoid_nodes/avoid_edges) only changes the cells that contain an avoided vertex or an endpoint of an avoided
+ * edge. customize recomputes the affected level 1 cells and shares every other clique with the base metric; a higher cell
+ * is opened instead of recomputed when its own search meets a restriction or a subcell changed, since searching through it
+ * once costs less than the |B| searches of its customization. A query is a Dijkstra that, away from the source and dest cells
+ * and the open cells, jumps across whole cells through their cliques. Paths are unpacked by repeating the searches inside
+ * the cells used, down to the original edges.
+ *
+ * @tparam T type of the vertex ids
+ */
+template <class T>
+class MultiLevelOverlay {
+public:
+    /**
+     * @brief Partitions g and customizes the unrestricted metric. g must outlive the overlay.
+     */
+    explicit MultiLevelOverlay(const CsrGraph<T> &g, int leafSize = 32, int bitsPerLevel = 3);
+
+    const CsrGraph<T> &getGraph() const;
+    int getNumLevels() const;
+    int getNumCells(int level) const;
+    const OverlayMetric &getBaseMetric() const;
+
+    /**
+     * @brief Customizes the metric for a restriction, recomputing the cliques of the affected level 1 cells and opening
+     * the higher cells affected.
+     *
+     * @param ctx search state of the calling thread; its backward labels are used
+     * @param avoid_nodes nodes that paths can't go through
+     * @param avoid_edges edges that paths can't go through
+     * @param metric used to return the customized metric, which shares the unaffected cells with the base metric
+     */
+    void customize(SearchContext &ctx, const std::unordered_set<T> &avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash> &avoid_edges, OverlayMetric &metric) const;
+
+    /**
+     * @brief Finds the driving time of the best path from source to dest with a bidirectional search over the overlay,
+     * stopping as BidirectionalDijkstra does. Restrictions have the same semantics: every vertex entered except source is
+     * checked against avoid_nodes, and every edge against avoid_edges.
+     *
+     * @param ctx search state of the calling thread; the forward and backward paths are left in its labels
+     * @param metric metric customized for avoid_nodes and avoid_edges
+     * @param source slot of the initial node of the path
+     * @param dest slot of the final node of the path
+     * @param avoid_nodes nodes that the path can't go through
+     * @param avoid_edges edges that the path can't go through
+     * @param meetingNode used to return the slot where both searches meet on the best path, -1 if there is no path
+     * @return int driving time of the best path, or -1 if there is no path
+     */
+    int query(SearchContext &ctx, const OverlayMetric &metric, int source, int dest, const std::unordered_set<T> &avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash> &avoid_edges, int &meetingNode) const;
+
+    /**
+     * @brief After a query, unpacks the path through meetingNode and puts its ids in front of the ids already in orderedIds.
+     * Takes the same arguments as the query. Sets orderedIds to {} if meetingNode is -1.
+     */
+    void getPath(SearchContext &ctx, const OverlayMetric &metric, int source, int dest, const std::unordered_set<T> &avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash> &avoid_edges, int meetingNode, std::list<T> &orderedIds) const;
+
+protected:
+    const CsrGraph<T> &graph;
+    int numLevels = 0;
+    int bitsPerLevel;
+    std::vector<int> code;              // leaf cell of each slot; its level-l cell is code >> ((l - 1) * bitsPerLevel)
+    std::vector<int> levelOffset;       // index of the first cell of each level, cells of all levels are numbered together
+    std::vector<int> boundaryOffset;    // boundary vertices of each cell
+    std::vector<int> boundary;
+    std::vector<int> boundaryIndex;     // [(l - 1) * V + v] = position of v among the boundary vertices of its level-l cell, -1 if none
+    OverlayMetric baseMetric;
+
+    int getCell(int level, int v) const;
+    int getGlobalCell(int level, int v) const;
+    int getQueryLevel(const OverlayMetric &metric, int v, int source, int dest) const;
+    void partition(std::vector<int> &vertices, int depth, int depthLimit, int prefix, std::vector<int> &mark, int &stamp);
+    bool isUsable(int e, const SearchRestrictions &restrictions) const;
+    void cellSearch(SearchLabels &labels, const OverlayMetric &metric, int level, int start, const SearchRestrictions &restrictions) const;
+    std::vector<int> customizeCell(SearchLabels &labels, const OverlayMetric &metric, int level, int cell, const SearchRestrictions &restrictions) const;
+    void unpackClique(SearchLabels &labels, const OverlayMetric &metric, int level, int from, int to, const SearchRestrictions &restrictions, std::vector<int> &edges) const;
+};
+
+template <class T>
+MultiLevelOverlay<T>::MultiLevelOverlay(const CsrGraph<T> &g, int leafSize, int bitsPerLevel): graph(g), bitsPerLevel(bitsPerLevel) {
+    int n = g.getNumVertex();
+    int depth = 0;
+    while ((n >> depth) > leafSize && depth < 30)
+        depth++;
+    // the top level keeps at least 2^bitsPerLevel cells, so that no cell spans a large part of the graph
+    numLevels = depth / bitsPerLevel;
+
+    code.assign(n, 0);
+    std::vector<int> vertices(n), mark(n, 0);
+    for (int v = 0; v < n; v++)
+        vertices[v] = v;
+    int stamp = 0;
+    partition(vertices, 0, depth, 0, mark, stamp);
+
+    levelOffset.assign(numLevels + 2, 0);
+    for (int l = 1; l <= numLevels; l++)
+        levelOffset[l + 1] = levelOffset[l] + (1 << (depth - (l - 1) * bitsPerLevel));
+    int numCells = levelOffset[numLevels + 1];
+
+    // boundary vertices, by cell, in slot order
+    boundaryIndex.assign((size_t) numLevels * n, -1);
+    boundaryOffset.assign(numCells + 1, 0);
+    std::vector<std::pair<int, int>> found; // (cell, slot)
+    for (int l = 1; l <= numLevels; l++) {
+        for (int v = 0; v < n; v++) {
+            bool isBoundary = false;
+            for (int e = g.outBegin(v); e < g.outEnd(v) && !isBoundary; e++)
+                isBoundary = g.getDrivingTime(e) != std::numeric_limits<int>::max() && getCell(l, g.getEdgeDest(e)) != getCell(l, v);
+            for (int i = g.inBegin(v); i < g.inEnd(v) && !isBoundary; i++)
+                isBoundary = g.getInDrivingTime(i) != std::numeric_limits<int>::max() && getCell(l, g.getInOrig(i)) != getCell(l, v);
+            if (isBoundary) {
+                int cell = getGlobalCell(l, v);
+                boundaryIndex[(size_t) (l - 1) * n + v] = boundaryOffset[cell + 1]++;
+                found.push_back({cell, v});
+            }
+        }
+    }
+    for (int c = 0; c < numCells; c++)
+        boundaryOffset[c + 1] += boundaryOffset[c];
+    boundary.resize(found.size());
+    std::vector<int> next(boundaryOffset.begin(), boundaryOffset.end() - 1);
+    for (auto &entry : found)
+        boundary[next[entry.first]++] = entry.second;
+
+    // base customization, bottom-up
+    SearchLabels labels;
+    SearchRestrictions none;
+    none.clear(n, graph.getNumEdges());
+    baseMetric.resize(numCells);
+    for (int l = 1; l <= numLevels; l++)
+        for (int c = 0; c < getNumCells(l); c++)
+            baseMetric.setWeights(levelOffset[l] + c, customizeCell(labels, baseMetric, l, c, none));
+}
+
+template <class T>
+const CsrGraph<T> &MultiLevelOverlay<T>::getGraph() const {
+    return graph;
+}
+
+template <class T>
+int MultiLevelOverlay<T>::getNumLevels() const {
+    return numLevels;
+}
+
+template <class T>
+int MultiLevelOverlay<T>::getNumCells(int level) const {
+    return levelOffset[level + 1] - levelOffset[level];
+}
+
+template <class T>
+const OverlayMetric &MultiLevelOverlay<T>::getBaseMetric() const {
+    return baseMetric;
+}
+
+template <class T>
+int MultiLevelOverlay<T>::getCell(int level, int v) const {
+    return code[v] >> ((level - 1) * bitsPerLevel);
+}
+
+template <class T>
+int MultiLevelOverlay<T>::getGlobalCell(int level, int v) const {
+    return levelOffset[level] + getCell(level, v);
+}
+
+/*
+ * Highest level whose cell of v holds neither source nor dest and is not open, 0 if there is none.
+ * The query crosses the cells of that level through their cliques. Open cells have open parents, so every lower level
+ * qualifies too.
+ */
+template <class T>
+int MultiLevelOverlay<T>::getQueryLevel(const OverlayMetric &metric, int v, int source, int dest) const {
+    for (int l = 1; l <= numLevels; l++)
+        if (getCell(l, v) == getCell(l, source) || getCell(l, v) == getCell(l, dest) || metric.isOpen(getGlobalCell(l, v)))
+            return l - 1;
+    return numLevels;
+}
+
+/*
+ * Splits vertices in two halves of a BFS order started at a pseudo-peripheral vertex, depthLimit times recursively.
+ * mark tells which vertices belong to the current group.
+ */
+template <class T>
+void MultiLevelOverlay<T>::partition(std::vector<int> &vertices, int depth, int depthLimit, int prefix, std::vector<int> &mark, int &stamp) {
+    if (depth == depthLimit || vertices.size() < 2) {
+        for (int v : vertices)
+            code[v] = prefix << (depthLimit - depth);
+        return;
+    }
+    int group = ++stamp;
+    for (int v : vertices)
+        mark[v] = group;
+    std::vector<int> order;
+    auto bfs = [&](int root) {
+        int visited = ++stamp;
+        order.clear();
+        order.push_back(root);
+        mark[root] = visited;
+        for (size_t i = 0; i < vertices.size(); i++) {
+            if (i == order.size()) { // the group is disconnected, continue from any vertex left
+                for (int v : vertices)
+                    if (mark[v] == group) {
+                        order.push_back(v);
+                        mark[v] = visited;
+                        break;
+                    }
+            }
+            int v = order[i];
+            auto visit = [&](int u) {
+                if (mark[u] == group) {
+                    mark[u] = visited;
+                    order.push_back(u);
+                }
+            };
+            for (int e = graph.outBegin(v); e < graph.outEnd(v); e++)
+                visit(graph.getEdgeDest(e));
+            for (int j = graph.inBegin(v); j < graph.inEnd(v); j++)
+                visit(graph.getInOrig(j));
+        }
+        for (int v : vertices)
+            mark[v] = group;
+    };
+    bfs(vertices[0]);
+    bfs(order.back());
+    size_t half = order.size() / 2;
+    std::vector<int> first(order.begin(), order.begin() + half), second(order.begin() + half, order.end());
+    vertices.clear();
+    vertices.shrink_to_fit();
+    partition(first, depth + 1, depthLimit, prefix * 2, mark, stamp);
+    partition(second, depth + 1, depthLimit, prefix * 2 + 1, mark, stamp);
+}
+
+template <class T>
+bool MultiLevelOverlay<T>::isUsable(int e, const SearchRestrictions &restrictions) const {
+    return graph.getDrivingTime(e) != std::numeric_limits<int>::max() && !restrictions.isNodeAvoided(graph.getEdgeDest(e)) && !restrictions.isEdgeAvoided(e);
+}
+
+/*
+ * Dijkstra from start restricted to its level cell: at level 1 over the original edges, above over the cliques of the
+ * level below plus the original edges between its subcells. It stops once every boundary vertex of the cell is settled.
+ * Each slot's path is the edge used to reach it, or -2 - u when it was reached through a clique from u.
+ */
+template <class T>
+void MultiLevelOverlay<T>::cellSearch(SearchLabels &labels, const OverlayMetric &metric, int level, int start, const SearchRestrictions &restrictions) const {
+    int n = graph.getNumVertex();
+    int cell = getCell(level, start);
+    labels.reset(n);
+    labels.setDist(start, 0);
+    SlotPriorityQueue pq(labels.getDistArray(), labels.getQueueIndexArray());
+    pq.insert(start);
+    auto relax = [&](int u, int cost, int path) {
+        if (labels.getDist(u) > cost) {
+            labels.setDist(u, cost);
+            labels.setPath(u, path);
+            if (!labels.isVisited(u)) {
+                pq.insert(u);
+                labels.setVisited(u, true);
+                labels.setProcessing(u, true);
+            } else {
+                pq.decreaseKey(u);
+            }
+        }
+    };
+    int global = levelOffset[level] + cell;
+    int boundaryLeft = boundaryOffset[global + 1] - boundaryOffset[global];
+    while (!pq.empty()) {
+        int v = pq.extractMin();
+        labels.setProcessing(v, false);
+        labels.setVisited(v, true);
+        if (boundaryIndex[(size_t) (level - 1) * n + v] != -1 && --boundaryLeft == 0) {
+            return;
+        }
+        if (level > 1) {
+            int sub = getGlobalCell(level - 1, v);
+            int b = boundaryOffset[sub + 1] - boundaryOffset[sub];
+            int i = boundaryIndex[(size_t) (level - 2) * n + v];
+            const int *weights = metric.getWeights(sub);
+            for (int j = 0; j < b; j++) {
+                int u = boundary[boundaryOffset[sub] + j];
+                int w = weights[i * b + j];
+                if (j == i || w == std::numeric_limits<int>::max() || (labels.isVisited(u) && !labels.isProcessing(u)))
+                    continue;
+                relax(u, labels.getDist(v) + w, -2 - v);
+            }
+        }
+        for (int e = graph.outBegin(v); e < graph.outEnd(v); e++) {
+            int u = graph.getEdgeDest(e);
+            if (getCell(level, u) != cell || (level > 1 && getCell(level - 1, u) == getCell(level - 1, v)) || (labels.isVisited(u) && !labels.isProcessing(u)) || !isUsable(e, restrictions))
+                continue;
+            relax(u, labels.getDist(v) + graph.getDrivingTime(e), e);
+        }
+    }
+}
+
+/*
+ * Computes the clique of a cell from the metric of the level below.
+ */
+template <class T>
+std::vector<int> MultiLevelOverlay<T>::customizeCell(SearchLabels &labels, const OverlayMetric &metric, int level, int cell, const SearchRestrictions &restrictions) const {
+    int global = levelOffset[level] + cell;
+    int b = boundaryOffset[global + 1] - boundaryOffset[global];
+    std::vector<int> weights((size_t) b * b, std::numeric_limits<int>::max());
+    for (int i = 0; i < b; i++) {
+        cellSearch(labels, metric, level, boundary[boundaryOffset[global] + i], restrictions);
+        for (int j = 0; j < b; j++)
+            weights[i * b + j] = labels.getDist(boundary[boundaryOffset[global] + j]);
+    }
+    return weights;
+}
+
+template <class T>
+void MultiLevelOverlay<T>::customize(SearchContext &ctx, const std::unordered_set<T> &avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash> &avoid_edges, OverlayMetric &metric) const {
+    metric.share(baseMetric);
+    SearchRestrictions &restrictions = ctx.getRestrictions();
+    restrictions.set(graph, avoid_nodes, avoid_edges);
+    std::vector<int> touched;
+    for (const T &id : avoid_nodes) {
+        int v = graph.findSlotById(id);
+        if (v != -1)
+            touched.push_back(v);
+    }
+    for (const std::pair<T, T> &edge : avoid_edges) {
+        int v = graph.findSlotById(edge.first), u = graph.findSlotById(edge.second);
+        if (v != -1 && u != -1) {
+            touched.push_back(v);
+            touched.push_back(u);
+        }
+    }
+    // a cell is affected if its own search meets a restriction or if the clique of one of its subcells changed
+    int n = graph.getNumVertex();
+    std::vector<char> affected(levelOffset[numLevels + 1], false);
+    for (int v : touched)
+        if (numLevels > 0)
+            affected[getGlobalCell(1, v)] = true;
+    for (int l = 2; l <= numLevels; l++)
+        for (int v : touched)
+            if (boundaryIndex[(size_t) (l - 2) * n + v] != -1)
+                affected[getGlobalCell(l, v)] = true;
+    for (int c = 0; numLevels > 0 && c < getNumCells(1); c++) {
+        if (!affected[c])
+            continue;
+        std::vector<int> weights = customizeCell(ctx.getBackward(), metric, 1, c, restrictions);
+        if (std::equal(weights.begin(), weights.end(), baseMetric.getWeights(c)))
+            continue;
+        metric.setWeights(c, std::move(weights));
+        if (numLevels > 1)
+            affected[levelOffset[2] + (c >> bitsPerLevel)] = true;
+    }
+    for (int l = 2; l <= numLevels; l++) {
+        for (int c = 0; c < getNumCells(l); c++) {
+            int global = levelOffset[l] + c;
+            if (!affected[global])
+                continue;
+            metric.setOpen(global);
+            if (l < numLevels)
+                affected[levelOffset[l + 1] + (c >> bitsPerLevel)] = true;
+        }
+    }
+}
+
+template <class T>
+int MultiLevelOverlay<T>::query(SearchContext &ctx, const OverlayMetric &metric, int source, int dest, const std::unordered_set<T> &avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash> &avoid_edges, int &meetingNode) const {
+    meetingNode = -1;
+    if (source == -1 || dest == -1) {
+        return -1;
+    }
+    int n = graph.getNumVertex();
+    SearchLabels &forward = ctx.getForward();
+    SearchLabels &backward = ctx.getBackward();
+    forward.reset(n);
+    backward.reset(n);
+    forward.setDist(source, 0);
+    if (source == dest) {
+        meetingNode = source;
+        return 0;
+    }
+    SearchRestrictions &restrictions = ctx.getRestrictions();
+    restrictions.set(graph, avoid_nodes, avoid_edges);
+    if (restrictions.isNodeAvoided(dest)) {
+        return -1;
+    }
+    backward.setDist(dest, 0);
+    SlotPriorityQueue forwardQueue(forward.getDistArray(), forward.getQueueIndexArray());
+    SlotPriorityQueue backwardQueue(backward.getDistArray(), backward.getQueueIndexArray());
+    forwardQueue.insert(source);
+    backwardQueue.insert(dest);
+    long long best = std::numeric_limits<long long>::max();
+    auto relax = [&](SearchLabels &labels, SlotPriorityQueue &pq, int u, int cost, int path) {
+        if (labels.getDist(u) > cost) {
+            labels.setDist(u, cost);
+            labels.setPath(u, path);
+            if (!labels.isVisited(u)) {
+                pq.insert(u);
+                labels.setVisited(u, true);
+                labels.setProcessing(u, true);
+            } else {
+                pq.decreaseKey(u);
+            }
+        }
+        if (forward.getDist(u) != std::numeric_limits<int>::max() && backward.getDist(u) != std::numeric_limits<int>::max() && (long long) forward.getDist(u) + backward.getDist(u) < best) {
+            best = (long long) forward.getDist(u) + backward.getDist(u);
+            meetingNode = u;
+        }
+    };
+    int lastForward = 0, lastBackward = 0;
+    while (!forwardQueue.empty() && !backwardQueue.empty()) {
+        if (lastForward + (long long) lastBackward >= best) {
+            break;
+        }
+        if (lastForward <= lastBackward) {
+            int v = forwardQueue.extractMin();
+            forward.setProcessing(v, false);
+            forward.setVisited(v, true);
+            lastForward = forward.getDist(v);
+            int level = getQueryLevel(metric, v, source, dest);
+            if (level > 0) {
+                int cell = getGlobalCell(level, v);
+                int b = boundaryOffset[cell + 1] - boundaryOffset[cell];
+                int i = boundaryIndex[(size_t) (level - 1) * n + v];
+                const int *weights = metric.getWeights(cell);
+                for (int j = 0; j < b; j++) {
+                    int u = boundary[boundaryOffset[cell] + j];
+                    int w = weights[i * b + j];
+                    if (j == i || w == std::numeric_limits<int>::max() || (forward.isVisited(u) && !forward.isProcessing(u)))
+                        continue;
+                    relax(forward, forwardQueue, u, lastForward + w, -2 - v);
+                }
+            }
+            for (int e = graph.outBegin(v); e < graph.outEnd(v); e++) {
+                int u = graph.getEdgeDest(e);
+                if ((level > 0 && getCell(level, u) == getCell(level, v)) || (forward.isVisited(u) && !forward.isProcessing(u)) || !isUsable(e, restrictions))
+                    continue;
+                relax(forward, forwardQueue, u, lastForward + graph.getDrivingTime(e), e);
+            }
+        } else {
+            int v = backwardQueue.extractMin();
+            backward.setProcessing(v, false);
+            backward.setVisited(v, true);
+            lastBackward = backward.getDist(v);
+            int level = getQueryLevel(metric, v, source, dest);
+            if (level > 0) {
+                int cell = getGlobalCell(level, v);
+                int b = boundaryOffset[cell + 1] - boundaryOffset[cell];
+                int i = boundaryIndex[(size_t) (level - 1) * n + v];
+                const int *weights = metric.getWeights(cell);
+                for (int j = 0; j < b; j++) {
+                    int u = boundary[boundaryOffset[cell] + j];
+                    int w = weights[j * b + i];
+                    if (j == i || w == std::numeric_limits<int>::max() || (backward.isVisited(u) && !backward.isProcessing(u)) || (u != source && restrictions.isNodeAvoided(u)))
+                        continue;
+                    relax(backward, backwardQueue, u, lastBackward + w, -2 - v);
+                }
+            }
+            for (int i = graph.inBegin(v); i < graph.inEnd(v); i++) {
+                int u = graph.getInOrig(i);
+                if ((level > 0 && getCell(level, u) == getCell(level, v)) || graph.getInDrivingTime(i) == std::numeric_limits<int>::max() || (backward.isVisited(u) && !backward.isProcessing(u)) || (u != source && restrictions.isNodeAvoided(u)) || restrictions.isEdgeAvoided(graph.getInEdge(i)))
+                    continue;
+                relax(backward, backwardQueue, u, lastBackward + graph.getInDrivingTime(i), graph.getInEdge(i));
+            }
+        }
+    }
+    if (meetingNode == -1) {
+        return -1;
+    }
+    return best;
+}
+
+/*
+ * Appends the original edges of the best path from "from" to "to" inside their level cell.
+ */
+template <class T>
+void MultiLevelOverlay<T>::unpackClique(SearchLabels &labels, const OverlayMetric &metric, int level, int from, int to, const SearchRestrictions &restrictions, std::vector<int> &edges) const {
+    cellSearch(labels, metric, level, from, restrictions);
+    std::vector<std::pair<int, int>> segments; // (edge or -2 - origin, end), read before the labels are reused
+    for (int v = to; v != from;) {
+        int path = labels.getPath(v);
+        segments.push_back({path, v});
+        v = path >= 0 ? graph.getEdgeOrig(path) : -2 - path;
+    }
+    for (auto it = segments.rbegin(); it != segments.rend(); it++) {
+        if (it->first >= 0)
+            edges.push_back(it->first);
+        else
+            unpackClique(labels, metric, level - 1, -2 - it->first, it->second, restrictions, edges);
+    }
+}
+
+template <class T>
+void MultiLevelOverlay<T>::getPath(SearchContext &ctx, const OverlayMetric &metric, int source, int dest, const std::unordered_set<T> &avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash> &avoid_edges, int meetingNode, std::list<T> &orderedIds) const {
+    if (meetingNode == -1) {
+        orderedIds = {};
+        return;
+    }
+    // (edge or -2 - other end of a clique, slot the segment starts at), in path order; read before the labels are reused
+    std::vector<std::pair<int, int>> segments;
+    for (int v = meetingNode; v != source;) {
+        int path = ctx.getForward().getPath(v);
+        int from = path >= 0 ? graph.getEdgeOrig(path) : -2 - path;
+        segments.push_back({path >= 0 ? path : -2 - v, from});
+        v = from;
+    }
+    std::reverse(segments.begin(), segments.end());
+    for (int v = meetingNode; v != dest;) {
+        int path = ctx.getBackward().getPath(v);
+        segments.push_back({path, v});
+        v = path >= 0 ? graph.getEdgeDest(path) : -2 - path;
+    }
+    ctx.getRestrictions().set(graph, avoid_nodes, avoid_edges);
+    std::vector<int> edges;
+    for (auto &segment : segments) {
+        if (segment.first >= 0) {
+            edges.push_back(segment.first);
+        } else {
+            int from = segment.second;
+            unpackClique(ctx.getBackward(), metric, getQueryLevel(metric, from, source, dest), from, -2 - segment.first, ctx.getRestrictions(), edges);
+        }
+    }
+    std::list<T> path = {graph.getId(source)};
+    for (int e : edges)
+        path.push_back(graph.getId(graph.getEdgeDest(e)));
+    orderedIds.splice(orderedIds.begin(), path);
+}
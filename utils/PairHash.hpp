@@ -5,13 +5,15 @@
 #include <utility>
 
 /**
- * @brief Enables the use of std::pair as a key in unordered containers by creating a hash function for it
+ * @brief Enables the use of std::pair as a key in unordered containers by creating a hash function for it.
+ * The two hashes are combined as boost::hash_combine does, so pairs of nearby ids don't collide.
  * 
  */
 struct pairHash {
     template <class T1, class T2>
     std::size_t operator()(const std::pair<T1, T2>& pair) const {
-        return std::hash<T1>()(pair.first) ^ (std::hash<T2>()(pair.second) << 1);
+        std::size_t seed = std::hash<T1>()(pair.first);
+        return seed ^ (std::hash<T2>()(pair.second) + 0x9e3779b9 + (seed << 6) + (seed >> 2));
     }
 };
 
@@ -1,57 +1,128 @@
 #pragma once
 
-#include "../utils/Graph.h"
+#include "../utils/CsrGraph.hpp"
+#include "../utils/SlotPriorityQueue.h"
+#include "../utils/SearchContext.hpp"
+#include "../utils/Landmarks.hpp"
 #include "../utils/PairHash.hpp"
 #include <unordered_set>
 
 /**
  * @brief Runs a Dijkstra algorithm on a graph, finding a path from the source to the dest node, while avoiding certain nodes and edges. Total time complexity is O(log(V)(E+V)) where V is the number of vertices and E is the number of edges.
- * 
- * @tparam T 
+ *
+ * @tparam T
  * @param g graph where the path will be found
- * @param source Initial node of the path
- * @param dest Final node of the path
+ * @param ctx search state of the calling thread; the edges used to reach each slot are left in its forward labels
+ * @param source slot of the initial node of the path
+ * @param dest slot of the final node of the path
  * @param avoid_nodes nodes that the path can't go through
  * @param avoid_edges edges that the path can't go through
  */
 template <class T>
-int RestrictedDijkstra(const Graph<T>& g, Vertex<T>* source, Vertex<T>* dest, const std::unordered_set<T>& avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash>& avoid_edges, std::vector<Vertex<T>*>& visitedVertices) {
-    if (source == nullptr) {
+int RestrictedDijkstra(const CsrGraph<T>& g, SearchContext& ctx, int source, int dest, const std::unordered_set<T>& avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash>& avoid_edges) {
+    if (source == -1) {
         return 0;
     }
-    int time;
-    source->setDist(0);
-    MutablePriorityQueue<Vertex<T>> pq;
-    visitedVertices.push_back(source);
+    SearchLabels& labels = ctx.getForward();
+    labels.reset(g.getNumVertex());
+    SearchRestrictions& restrictions = ctx.getRestrictions();
+    restrictions.set(g, avoid_nodes, avoid_edges);
+    labels.setDist(source, 0);
+    SlotPriorityQueue pq(labels.getDistArray(), labels.getQueueIndexArray());
     pq.insert(source);
     while (!pq.empty()) {
-        Vertex<T>* v = pq.extractMin();
-        v->setProcessing(false);
+        int v = pq.extractMin();
+        labels.setProcessing(v, false);
         if (v == dest) {
-            time = dest->getDist();
-            cleanUpVisitedAndDist(visitedVertices);
-            return time;
+            return labels.getDist(dest);
         }
-        for (Edge<T>* e : v->getAdj()) {
-            Vertex<T>* u = e->getDest();
-            if (v->getDist() == std::numeric_limits<int>::max() || e->getDrivingTime() == std::numeric_limits<int>::max() || (u->isVisited()&&!u->isProcessing())  || avoid_nodes.find(u->getId()) != avoid_nodes.end() || avoid_edges.find({v->getId(), u->getId()}) != avoid_edges.end()) {
+        for (int e = g.outBegin(v); e < g.outEnd(v); e++) {
+            int u = g.getEdgeDest(e);
+            if (labels.getDist(v) == std::numeric_limits<int>::max() || g.getDrivingTime(e) == std::numeric_limits<int>::max() || (labels.isVisited(u)&&!labels.isProcessing(u)) || restrictions.isNodeAvoided(u) || restrictions.isEdgeAvoided(e)) {
                 continue;
             }
-            int cost = v->getDist() + e->getDrivingTime();
-            if (u->getDist() > cost) {
-                u->setDist(cost);
-                u->setPath(e);
-                if (!u->isVisited()) {
+            int cost = labels.getDist(v) + g.getDrivingTime(e);
+            if (labels.getDist(u) > cost) {
+                labels.setDist(u, cost);
+                labels.setPath(u, e);
+                if (!labels.isVisited(u)) {
                     pq.insert(u);
-                    u->setVisited(true);
-                    u->setProcessing(true);
-                    visitedVertices.push_back(u);
-                } else if (u->isProcessing()) {
+                    labels.setVisited(u, true);
+                    labels.setProcessing(u, true);
+                } else if (labels.isProcessing(u)) {
                     pq.decreaseKey(u);
                 }
             }
         }
     }
-    cleanUpVisitedAndDist(visitedVertices);
     return -1;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief A* variant of RestrictedDijkstra, goal-directed by ALT landmark lower bounds. It searches with reduced edge costs
+ * w(v,u) + h(u) - h(v), which are non-negative because the landmark potential is consistent, so the same priority queues apply.
+ * Worst case time complexity is the same as RestrictedDijkstra plus O(K) per relaxation, where K is the number of landmarks.
+ *
+ * @tparam T
+ * @param g graph where the path will be found
+ * @param ctx search state of the calling thread; the edges used to reach each slot are left in its forward labels
+ * @param landmarks landmark tables built for g
+ * @param source slot of the initial node of the path
+ * @param dest slot of the final node of the path
+ * @param avoid_nodes nodes that the path can't go through
+ * @param avoid_edges edges that the path can't go through
+ * @return int driving time of the best path, or -1 if there is no path
+ */
+template <class T>
+int RestrictedAStar(const CsrGraph<T>& g, SearchContext& ctx, const Landmarks<T>& landmarks, int source, int dest, const std::unordered_set<T>& avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash>& avoid_edges) {
+    if (source == -1) {
+        return 0;
+    }
+    SearchLabels& labels = ctx.getForward();
+    labels.reset(g.getNumVertex());
+    SearchRestrictions& restrictions = ctx.getRestrictions();
+    restrictions.set(g, avoid_nodes, avoid_edges);
+    if (dest == -1) {
+        return -1;
+    }
+    LandmarkPotential<T> potential(landmarks, {{dest, 0}}, false);
+    int sourcePotential = potential.get(source);
+    if (sourcePotential == -1) {
+        return -1;
+    }
+    labels.setDist(source, 0);
+    SlotPriorityQueue pq(labels.getDistArray(), labels.getQueueIndexArray());
+    pq.insert(source);
+    while (!pq.empty()) {
+        int v = pq.extractMin();
+        labels.setProcessing(v, false);
+        labels.setVisited(v, true);
+        if (v == dest) {
+            return labels.getDist(dest) + sourcePotential;
+        }
+        int vPotential = potential.get(v);
+        for (int e = g.outBegin(v); e < g.outEnd(v); e++) {
+            int u = g.getEdgeDest(e);
+            if (g.getDrivingTime(e) == std::numeric_limits<int>::max() || (labels.isVisited(u)&&!labels.isProcessing(u)) || restrictions.isNodeAvoided(u) || restrictions.isEdgeAvoided(e)) {
+                continue;
+            }
+            int uPotential = potential.get(u);
+            if (uPotential == -1) {
+                continue;
+            }
+            int cost = labels.getDist(v) + g.getDrivingTime(e) + uPotential - vPotential;
+            if (labels.getDist(u) > cost) {
+                labels.setDist(u, cost);
+                labels.setPath(u, e);
+                if (!labels.isVisited(u)) {
+                    pq.insert(u);
+                    labels.setVisited(u, true);
+                    labels.setProcessing(u, true);
+                } else {
+                    pq.decreaseKey(u);
+                }
+            }
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include "SearchRestrictions.hpp"
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+/************************* SearchLabels  **************************/
+
+/**
+ * @brief Labels of the vertices reached by one search direction, stored in flat arrays indexed by slot.
+ *
+ * Instead of cleaning every label after a query, each slot carries the epoch in which it was last written.
+ * reset starts a new epoch in O(1), and a slot whose stamp is older reads as unreached
+ * (infinite distance, no path, not visited).
+ */
+class SearchLabels {
+public:
+    /**
+     * @brief Starts a new search over a graph with numVertex vertices, invalidating every label in O(1) amortized time.
+     */
+    void reset(int numVertex);
+
+    int getDist(int v) const;
+    int getPath(int v) const;
+    bool isVisited(int v) const;
+    bool isProcessing(int v) const;
+
+    void setDist(int v, int dist);
+    void setPath(int v, int path);
+    void setVisited(int v, bool visited);
+    void setProcessing(int v, bool processing);
+
+    /*
+     * Raw arrays used by the priority queues. Only entries of slots currently in the queue are meaningful.
+     */
+    const std::vector<int> &getDistArray() const;
+    std::vector<int> &getQueueIndexArray();
+
+protected:
+    unsigned epoch = 0;
+    std::vector<unsigned> stamp;   // epoch in which each slot was last written
+    std::vector<int> dist;
+    std::vector<int> path;         // index of the edge used to reach each slot, -1 if none
+    std::vector<int> queueIndex;   // required by SlotPriorityQueue
+    std::vector<char> visited;
+    std::vector<char> processing;
+
+    void touch(int v);
+};
+
+inline void SearchLabels::reset(int numVertex) {
+    if (stamp.size() < static_cast<std::size_t>(numVertex)) {
+        stamp.resize(numVertex, 0);
+        dist.resize(numVertex);
+        path.resize(numVertex);
+        queueIndex.resize(numVertex, 0);
+        visited.resize(numVertex);
+        processing.resize(numVertex);
+    }
+    epoch++;
+    if (epoch == 0) { // wrapped around, old stamps could be mistaken for the new epoch
+        std::fill(stamp.begin(), stamp.end(), 0);
+        epoch = 1;
+    }
+}
+
+inline void SearchLabels::touch(int v) {
+    if (stamp[v] == epoch)
+        return;
+    stamp[v] = epoch;
+    dist[v] = std::numeric_limits<int>::max();
+    path[v] = -1;
+    visited[v] = false;
+    processing[v] = false;
+}
+
+inline int SearchLabels::getDist(int v) const {
+    return stamp[v] == epoch ? dist[v] : std::numeric_limits<int>::max();
+}
+
+inline int SearchLabels::getPath(int v) const {
+    return stamp[v] == epoch ? path[v] : -1;
+}
+
+inline bool SearchLabels::isVisited(int v) const {
+    return stamp[v] == epoch && visited[v];
+}
+
+inline bool SearchLabels::isProcessing(int v) const {
+    return stamp[v] == epoch && processing[v];
+}
+
+inline void SearchLabels::setDist(int v, int dist) {
+    touch(v);
+    this->dist[v] = dist;
+}
+
+inline void SearchLabels::setPath(int v, int path) {
+    touch(v);
+    this->path[v] = path;
+}
+
+inline void SearchLabels::setVisited(int v, bool visited) {
+    touch(v);
+    this->visited[v] = visited;
+}
+
+inline void SearchLabels::setProcessing(int v, bool processing) {
+    touch(v);
+    this->processing[v] = processing;
+}
+
+inline const std::vector<int> &SearchLabels::getDistArray() const {
+    return dist;
+}
+
+inline std::vector<int> &SearchLabels::getQueueIndexArray() {
+    return queueIndex;
+}
+
+/************************* SearchContext  **************************/
+
+/**
+ * @brief Per-query search state, kept outside the graph so that one read-only CsrGraph can serve several threads,
+ * each owning its own context. A context is reused across queries without any cleanup pass.
+ *
+ * forward holds the labels of searches over outgoing edges (driving), backward the labels of searches
+ * over incoming edges (the reverse walking search, or the backward half of a bidirectional search).
+ * restrictions holds the avoided vertices and edges of the query, set by each search from its avoid sets.
+ */
+class SearchContext {
+public:
+    SearchLabels &getForward();
+    SearchLabels &getBackward();
+    const SearchLabels &getForward() const;
+    const SearchLabels &getBackward() const;
+    SearchRestrictions &getRestrictions();
+    const SearchRestrictions &getRestrictions() const;
+
+protected:
+    SearchLabels forward;
+    SearchLabels backward;
+    SearchRestrictions restrictions;
+};
+
+inline SearchLabels &SearchContext::getForward() {
+    return forward;
+}
+
+inline SearchLabels &SearchContext::getBackward() {
+    return backward;
+}
+
+inline const SearchLabels &SearchContext::getForward() const {
+    return forward;
+}
+
+inline const SearchLabels &SearchContext::getBackward() const {
+    return backward;
+}
+
+inline SearchRestrictions &SearchContext::getRestrictions() {
+    return restrictions;
+}
+
+inline const SearchRestrictions &SearchContext::getRestrictions() const {
+    return restrictions;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "CsrGraph.hpp"
+#include "PairHash.hpp"
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+
+/************************* SearchRestrictions  **************************/
+
+/**
+ * @brief Avoided vertices and edges of one query, marked by slot and by edge index so a search tests them with one array
+ * read per relaxation instead of hashing ids.
+ *
+ * As with SearchLabels, every mark carries the epoch in which it was set: set starts a new epoch, so only the restrictions
+ * of the query are written, and older marks read as not avoided.
+ */
+class SearchRestrictions {
+public:
+    /**
+     * @brief Replaces the restrictions with avoid_nodes and avoid_edges of g. Ids that aren't in g are ignored, and an avoided
+     * edge marks every edge between its two vertices. Runs in O(N + D) amortized time, where N is the number of restrictions
+     * and D the sum of the out-degrees of the avoided edges' origins.
+     */
+    template <class T>
+    void set(const CsrGraph<T> &g, const std::unordered_set<T> &avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash> &avoid_edges);
+
+    /**
+     * @brief Removes every restriction of a graph with numVertex vertices and numEdges edges in O(1) amortized time.
+     */
+    void clear(int numVertex, int numEdges);
+
+    void avoidNode(int v);
+    void avoidEdge(int e);
+
+    bool isNodeAvoided(int v) const;
+    bool isEdgeAvoided(int e) const;
+
+protected:
+    unsigned epoch = 0;
+    std::vector<unsigned> nodeStamp;   // epoch in which each slot was avoided
+    std::vector<unsigned> edgeStamp;   // epoch in which each edge was avoided
+};
+
+template <class T>
+void SearchRestrictions::set(const CsrGraph<T> &g, const std::unordered_set<T> &avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash> &avoid_edges) {
+    clear(g.getNumVertex(), g.getNumEdges());
+    for (const T &id : avoid_nodes) {
+        int v = g.findSlotById(id);
+        if (v != -1)
+            avoidNode(v);
+    }
+    for (const std::pair<T, T> &edge : avoid_edges) {
+        int v = g.findSlotById(edge.first), u = g.findSlotById(edge.second);
+        if (v == -1 || u == -1)
+            continue;
+        for (int e = g.outBegin(v); e < g.outEnd(v); e++)
+            if (g.getEdgeDest(e) == u)
+                avoidEdge(e);
+    }
+}
+
+inline void SearchRestrictions::clear(int numVertex, int numEdges) {
+    if (nodeStamp.size() < static_cast<std::size_t>(numVertex))
+        nodeStamp.resize(numVertex, 0);
+    if (edgeStamp.size() < static_cast<std::size_t>(numEdges))
+        edgeStamp.resize(numEdges, 0);
+    epoch++;
+    if (epoch == 0) { // wrapped around, old stamps could be mistaken for the new epoch
+        std::fill(nodeStamp.begin(), nodeStamp.end(), 0);
+        std::fill(edgeStamp.begin(), edgeStamp.end(), 0);
+        epoch = 1;
+    }
+}
+
+inline void SearchRestrictions::avoidNode(int v) {
+    nodeStamp[v] = epoch;
+}
+
+inline void SearchRestrictions::avoidEdge(int e) {
+    edgeStamp[e] = epoch;
+}
+
+inline bool SearchRestrictions::isNodeAvoided(int v) const {
+    return nodeStamp[v] == epoch;
+}
+
+inline bool SearchRestrictions::isEdgeAvoided(int e) const {
+    return edgeStamp[e] == epoch;
+}
@@ -0,0 +1,86 @@
+/*
+ * SlotPriorityQueue.h
+ * Mutable priority queue over vertex slots of a CsrGraph, required by the Dijkstra algorithms.
+ * Same binary heap as MutablePriorityQueue, but keys and heap positions live in flat arrays
+ * indexed by slot instead of inside each Vertex.
+ */
+
+#ifndef DA_TP_CLASSES_SLOTPRIORITYQUEUE
+#define DA_TP_CLASSES_SLOTPRIORITYQUEUE
+
+#include <vector>
+
+class SlotPriorityQueue {
+    std::vector<int> H;
+    const std::vector<int> &key;    // key of each slot (its distance)
+    std::vector<int> &queueIndex;   // position of each slot in H
+    void heapifyUp(unsigned i);
+    void heapifyDown(unsigned i);
+    inline void set(unsigned i, int x);
+public:
+    SlotPriorityQueue(const std::vector<int> &key, std::vector<int> &queueIndex);
+    void insert(int x);
+    int extractMin();
+    void decreaseKey(int x);
+    bool empty();
+};
+
+inline SlotPriorityQueue::SlotPriorityQueue(const std::vector<int> &key, std::vector<int> &queueIndex): key(key), queueIndex(queueIndex) {
+    H.push_back(-1);
+    // indices will be used starting in 1
+    // to facilitate parent/child calculations
+}
+
+inline bool SlotPriorityQueue::empty() {
+    return H.size() == 1;
+}
+
+inline int SlotPriorityQueue::extractMin() {
+    auto x = H[1];
+    H[1] = H.back();
+    H.pop_back();
+    if (H.size() > 1) heapifyDown(1);
+    queueIndex[x] = 0;
+    return x;
+}
+
+inline void SlotPriorityQueue::insert(int x) {
+    H.push_back(x);
+    heapifyUp(H.size() - 1);
+}
+
+inline void SlotPriorityQueue::decreaseKey(int x) {
+    heapifyUp(queueIndex[x]);
+}
+
+inline void SlotPriorityQueue::heapifyUp(unsigned i) {
+    auto x = H[i];
+    while (i > 1 && key[x] < key[H[i / 2]]) {
+        set(i, H[i / 2]);
+        i = i / 2;
+    }
+    set(i, x);
+}
+
+inline void SlotPriorityQueue::heapifyDown(unsigned i) {
+    auto x = H[i];
+    while (true) {
+        unsigned k = i * 2;
+        if (k >= H.size())
+            break;
+        if (k + 1 < H.size() && key[H[k + 1]] < key[H[k]])
+            ++k; // right child of i
+        if (!(key[H[k]] < key[x]))
+            break;
+        set(i, H[k]);
+        i = k;
+    }
+    set(i, x);
+}
+
+inline void SlotPriorityQueue::set(unsigned i, int x) {
+    H[i] = x;
+    queueIndex[x] = i;
+}
+
+#endif /* DA_TP_CLASSES_SLOTPRIORITYQUEUE */
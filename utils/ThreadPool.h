@@ -0,0 +1,164 @@
+/*
+ * ThreadPool.h
+ * Fixed pool of worker threads with one task deque per worker. Each worker takes the oldest task of its own
+ * deque and, when that is empty, steals the newest task of another worker's deque, so uneven tasks keep every
+ * core busy without a single shared queue becoming the bottleneck.
+ */
+
+#ifndef DA_TP_CLASSES_THREADPOOL
+#define DA_TP_CLASSES_THREADPOOL
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+    /*
+     * A task receives the index of the worker running it, in [0, getNumWorkers()),
+     * so it can use state owned by that worker.
+     */
+    using Task = std::function<void(int)>;
+
+    /*
+     * Starts numWorkers threads; 0 uses one per hardware thread.
+     */
+    explicit ThreadPool(int numWorkers = 0);
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+    ~ThreadPool();
+
+    /*
+     * Queues a task on the next worker, in round-robin order.
+     */
+    void submit(Task task);
+    /*
+     * Blocks until every submitted task has finished.
+     */
+    void wait();
+
+    int getNumWorkers() const;
+
+    /*
+     * Number of hardware threads, at least 1.
+     */
+    static int hardwareThreads();
+
+protected:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex mutex;                   // guards queued, running and stopping, used by the condition variables
+    std::condition_variable available;  // signalled when a task is queued or the pool stops
+    std::condition_variable finished;   // signalled when the last running task ends
+    int queued = 0;                     // tasks in the deques
+    int running = 0;                    // tasks queued or being run
+    bool stopping = false;
+    std::atomic<unsigned> next{0};      // worker that receives the next submitted task
+
+    void run(int worker);
+    bool take(int worker, Task &task);
+};
+
+inline ThreadPool::ThreadPool(int numWorkers) {
+    if (numWorkers <= 0)
+        numWorkers = hardwareThreads();
+    for (int i = 0; i < numWorkers; i++)
+        workers.emplace_back(new Worker());
+    for (int i = 0; i < numWorkers; i++)
+        workers[i]->thread = std::thread(&ThreadPool::run, this, i);
+}
+
+inline ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    available.notify_all();
+    for (auto &worker : workers)
+        worker->thread.join();
+}
+
+inline void ThreadPool::submit(Task task) {
+    Worker &worker = *workers[next++ % workers.size()];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued++;
+        running++;
+    }
+    available.notify_one();
+}
+
+inline void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return running == 0; });
+}
+
+inline int ThreadPool::getNumWorkers() const {
+    return workers.size();
+}
+
+inline int ThreadPool::hardwareThreads() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/*
+ * Takes the oldest task of the worker's own deque, or steals the newest one of another deque.
+ */
+inline bool ThreadPool::take(int worker, Task &task) {
+    int n = workers.size();
+    for (int i = 0; i < n; i++) {
+        Worker &victim = *workers[(worker + i) % n];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty())
+            continue;
+        if (i == 0) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        } else {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+        }
+        return true;
+    }
+    return false;
+}
+
+inline void ThreadPool::run(int worker) {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            available.wait(lock, [this] { return queued > 0 || stopping; });
+            if (queued == 0)
+                return;
+            queued--;
+        }
+        // queued counted this task, so some deque holds it until it is taken
+        Task task;
+        while (!take(worker, task))
+            std::this_thread::yield();
+        task(worker);
+        bool last;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            last = --running == 0;
+        }
+        if (last)
+            finished.notify_all();
+    }
+}
+
+#endif /* DA_TP_CLASSES_THREADPOOL */
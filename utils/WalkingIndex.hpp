@@ -0,0 +1,226 @@
+#pragma once
+
+#include "../utils/CsrGraph.hpp"
+#include "../utils/SlotPriorityQueue.h"
+#include "../utils/SearchContext.hpp"
+#include "../utils/PairHash.hpp"
+#include "../utils/ThreadPool.h"
+#include <cstddef>
+#include <limits>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/************************* WalkingIndex  **************************/
+
+/**
+ * @brief Parking nodes within walking distance of every vertex, so driving-walking queries don't have to search for the
+ * parking candidates of their destination.
+ *
+ * For each vertex d, a reverse walking search bounded by maxRadius records the parking nodes that can walk to d, sorted by
+ * walking time, with their first hop towards d, along with the vertices on their walking paths. The search is the one
+ * walkingReverseDijsktra runs without restrictions, so for any walking limit up to maxRadius the candidates, their
+ * walking times and their walking paths are exactly the ones it finds.
+ *
+ * Building takes O(V·(B+F)·log B / p) time with p threads, where B and F are the number of vertices and edges within
+ * maxRadius of a vertex, and the index takes O(V·B) memory.
+ *
+ * @tparam T type of the vertex ids
+ */
+template <class T>
+class WalkingIndex {
+public:
+    /**
+     * @brief Builds the index of g for walking times up to maxRadius. g must outlive it.
+     *
+     * @param numThreads number of threads; 0 uses one per hardware thread
+     */
+    WalkingIndex(const CsrGraph<T> &g, int maxRadius, int numThreads = 0);
+
+    const CsrGraph<T> &getGraph() const;
+    int getMaxRadius() const;
+    /**
+     * @brief Number of vertices stored over all the vertices, each taking three ints.
+     */
+    std::size_t getNumEntries() const;
+
+    /**
+     * @brief Whether a walk to dest of at most maxWalkTime can be answered by the index: maxWalkTime is within the radius
+     * and no avoided node or segment lies on the walking path of a candidate. Runs in O(B).
+     */
+    bool covers(int dest, int maxWalkTime, const std::unordered_set<T> &avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash> &avoid_edges) const;
+
+    /**
+     * @brief Parking candidates of dest, as walkingReverseDijsktra(g, ctx, dest, exclude, maxWalkTime, ...) would find them
+     * without restrictions. Runs in O(C) where C is the number of candidates.
+     *
+     * @param reacheableVertices map that relates slots of the parking nodes and the time needed to walk from them to dest
+     * @return int returns 0 as success, -1 if no reacheable vertices were found.
+     */
+    int getReacheableParking(int dest, int exclude, int maxWalkTime, std::unordered_map<int, int> &reacheableVertices) const;
+
+    /**
+     * @brief Appends to orderedIds the ids of the walking path from parkingNode to dest, without parkingNode, as
+     * getDrivingAndWalkingPath does. Runs in O(B).
+     */
+    void getWalkingPath(int dest, int parkingNode, std::list<T> &orderedIds) const;
+
+protected:
+    struct Entry {
+        int slot;
+        int walk;   // walking time from slot to the vertex of the entry's block
+        int next;   // entry of the next vertex on the walking path, -1 at the block's vertex
+    };
+
+    const CsrGraph<T> &graph;
+    int maxRadius;
+    std::vector<std::size_t> begin;   // entries of vertex d in [begin[d], begin[d + 1])
+    std::vector<Entry> entries;       // sorted by walk within each block
+
+    void search(int dest, SearchLabels &labels, std::vector<int> &settled, std::vector<Entry> &block) const;
+};
+
+template <class T>
+WalkingIndex<T>::WalkingIndex(const CsrGraph<T> &g, int maxRadius, int numThreads): graph(g), maxRadius(maxRadius) {
+    int n = g.getNumVertex();
+    std::vector<std::vector<Entry>> blocks(n);
+    {
+        ThreadPool pool(numThreads);
+        std::vector<SearchContext> contexts(pool.getNumWorkers());
+        std::vector<std::vector<int>> settled(pool.getNumWorkers());
+        const int chunk = 64;
+        for (int first = 0; first < n; first += chunk) {
+            pool.submit([this, first, n, &blocks, &contexts, &settled](int worker) {
+                for (int d = first; d < n && d < first + chunk; d++)
+                    search(d, contexts[worker].getBackward(), settled[worker], blocks[d]);
+            });
+        }
+        pool.wait();
+    }
+    begin.assign(n + 1, 0);
+    for (int d = 0; d < n; d++)
+        begin[d + 1] = begin[d] + blocks[d].size();
+    entries.reserve(begin[n]);
+    for (int d = 0; d < n; d++) {
+        for (Entry &entry : blocks[d]) {
+            if (entry.next != -1)
+                entry.next += begin[d];
+            entries.push_back(entry);
+        }
+        std::vector<Entry>().swap(blocks[d]);
+    }
+}
+
+template <class T>
+const CsrGraph<T> &WalkingIndex<T>::getGraph() const {
+    return graph;
+}
+
+template <class T>
+int WalkingIndex<T>::getMaxRadius() const {
+    return maxRadius;
+}
+
+template <class T>
+std::size_t WalkingIndex<T>::getNumEntries() const {
+    return entries.size();
+}
+
+/*
+ * Same search as walkingReverseDijsktra, bounded by maxRadius. The block keeps the parking nodes and the vertices on their
+ * paths, in the order they were settled; next is an index within the block.
+ */
+template <class T>
+void WalkingIndex<T>::search(int dest, SearchLabels &labels, std::vector<int> &settled, std::vector<Entry> &block) const {
+    labels.reset(graph.getNumVertex());
+    labels.setDist(dest, 0);
+    SlotPriorityQueue pq(labels.getDistArray(), labels.getQueueIndexArray());
+    pq.insert(dest);
+    settled.clear();
+    while (!pq.empty()) {
+        int v = pq.extractMin();
+        labels.setProcessing(v, false);
+        if (labels.getDist(v) > maxRadius)
+            break;
+        settled.push_back(v);
+        for (int i = graph.inBegin(v); i < graph.inEnd(v); i++) {
+            int u = graph.getInOrig(i);
+            if (labels.getDist(v) == std::numeric_limits<int>::max() || graph.getInWalkingTime(i) == std::numeric_limits<int>::max() || (labels.isVisited(u) && !labels.isProcessing(u)))
+                continue;
+            if (labels.getDist(u) > labels.getDist(v) + graph.getInWalkingTime(i)) {
+                labels.setDist(u, labels.getDist(v) + graph.getInWalkingTime(i));
+                labels.setPath(u, graph.getInEdge(i));
+                if (!labels.isVisited(u)) {
+                    pq.insert(u);
+                    labels.setVisited(u, true);
+                    labels.setProcessing(u, true);
+                } else if (labels.isProcessing(u)) {
+                    pq.decreaseKey(u);
+                }
+            }
+        }
+    }
+
+    // A vertex is kept if it's a parking node or the next hop of a kept vertex; settled vertices come after their next
+    // hop, so walking the settle order backwards finds every kept vertex before its next hop. The stamps are reused
+    // as marks: processing is false for every settled vertex at this point.
+    for (auto it = settled.rbegin(); it != settled.rend(); ++it) {
+        int v = *it;
+        if (!graph.getParking(v) && !labels.isProcessing(v))
+            continue;
+        labels.setProcessing(v, true);
+        int e = labels.getPath(v);
+        if (e != -1)
+            labels.setProcessing(graph.getEdgeDest(e), true);
+    }
+    block.clear();
+    std::unordered_map<int, int> position;
+    for (int v : settled) {
+        if (!labels.isProcessing(v))
+            continue;
+        int e = labels.getPath(v);
+        position[v] = block.size();
+        block.push_back({v, labels.getDist(v), e == -1 ? -1 : position.at(graph.getEdgeDest(e))});
+    }
+}
+
+template <class T>
+bool WalkingIndex<T>::covers(int dest, int maxWalkTime, const std::unordered_set<T> &avoid_nodes, const std::unordered_set<std::pair<T, T>, pairHash> &avoid_edges) const {
+    if (dest == -1 || maxWalkTime > maxRadius)
+        return false;
+    if (avoid_nodes.empty() && avoid_edges.empty())
+        return true;
+    for (std::size_t i = begin[dest]; i < begin[dest + 1] && entries[i].walk <= maxWalkTime; i++) {
+        const Entry &entry = entries[i];
+        if (entry.next == -1)
+            continue;
+        T id = graph.getId(entry.slot);
+        if (avoid_nodes.find(id) != avoid_nodes.end() || avoid_edges.find({id, graph.getId(entries[entry.next].slot)}) != avoid_edges.end())
+            return false;
+    }
+    return true;
+}
+
+template <class T>
+int WalkingIndex<T>::getReacheableParking(int dest, int exclude, int maxWalkTime, std::unordered_map<int, int> &reacheableVertices) const {
+    if (dest == -1)
+        return -1;
+    for (std::size_t i = begin[dest]; i < begin[dest + 1] && entries[i].walk <= maxWalkTime; i++) {
+        int v = entries[i].slot;
+        if (graph.getParking(v) && v != dest && v != exclude)
+            reacheableVertices.insert({v, entries[i].walk});
+    }
+    return reacheableVertices.empty() ? -1 : 0;
+}
+
+template <class T>
+void WalkingIndex<T>::getWalkingPath(int dest, int parkingNode, std::list<T> &orderedIds) const {
+    for (std::size_t i = begin[dest]; i < begin[dest + 1]; i++) {
+        if (entries[i].slot != parkingNode)
+            continue;
+        for (int next = entries[i].next; next != -1; next = entries[next].next)
+            orderedIds.push_back(graph.getId(entries[next].slot));
+        return;
+    }
+}